@@ -0,0 +1,32 @@
+#version 150
+// ^ Change this to version 130 if you have compatibility issues
+
+//places one JointGizmo per instance, instance i at joint u_JointOffset + i
+//of the palette. the palette holds plain world matrices here, not skinning
+//ones, so the gizmo follows the joint itself
+
+uniform mat4 u_ViewProj;    // The matrix that defines the camera's transformation.
+
+uniform samplerBuffer u_JointMatrices; // world matrices, joint i is texels 4i to 4i + 3
+uniform int u_JointOffset;             // where the drawn skeleton starts in u_JointMatrices
+uniform int u_SelectedJoint;           // instance to highlight, -1 for none
+
+in vec4 vs_Pos;             // The gizmo's vertex positions, around the origin
+
+out vec4 fs_Col;
+
+mat4 jointMatrix(int texel) {
+    return mat4(texelFetch(u_JointMatrices, texel),
+                texelFetch(u_JointMatrices, texel + 1),
+                texelFetch(u_JointMatrices, texel + 2),
+                texelFetch(u_JointMatrices, texel + 3));
+}
+
+void main()
+{
+    fs_Col = gl_InstanceID == u_SelectedJoint ? vec4(0.8, 0, 0.8, 1) : vec4(1, 1, 1, 1);
+
+    vec4 worldposition = jointMatrix(4 * (u_JointOffset + gl_InstanceID)) * vs_Pos;
+
+    gl_Position = u_ViewProj * worldposition;
+}
@@ -20,8 +20,10 @@ uniform mat4 u_ViewProj;    // The matrix that defines the camera's transformati
                             // We've written a static matrix for you to use for HW2,
                             // but in HW3 you'll have to generate one yourself
 
-uniform mat4[100] u_Binds;          // arr of bind matrices
-uniform mat4[100] u_Transforms;     // arr of transformation matrices
+uniform samplerBuffer u_JointMatrices; // every skeleton's skinning matrices (world * bind) this
+                                       // frame, see JointPalette. joint i is texels 4i to 4i + 3
+uniform int u_JointOffset;             // where this mesh's skeleton starts in u_JointMatrices
+uniform int u_JointsPerInstance;       // how far apart instances' skeletons are when drawn instanced
 
 in vec4 vs_Pos;             // The array of vertex positions passed to the shader
 
@@ -29,8 +31,9 @@ in vec4 vs_Nor;             // The array of vertex normals passed to the shader
 
 in vec4 vs_Col;             // The array of vertex colors passed to the shader.
 
-in ivec2 vs_Ids;            // ids of joints
-in vec2 vs_Weights;         // weights of joints
+in uvec4 vs_Ids;            // ids of up to 4 joints, heaviest first
+in vec4 vs_Weights;         // their weights, unorm16 so they arrive in [0, 1] and sum to 1.
+                            // unused slots have weight 0, unbound vertices all 0
 
 out vec3 fs_Pos;
 out vec4 fs_Nor;            // The array of normals that has been transformed by u_ModelInvTr. This is implicitly passed to the fragment shader.
@@ -56,25 +59,40 @@ vec3 heatMap(float t) {
     }
 }
 
+mat4 jointMatrix(int texel) {
+    return mat4(texelFetch(u_JointMatrices, texel),
+                texelFetch(u_JointMatrices, texel + 1),
+                texelFetch(u_JointMatrices, texel + 2),
+                texelFetch(u_JointMatrices, texel + 3));
+}
+
 void main()
 {
     fs_Col = vs_Col;                         // Pass the vertex colors to the fragment shader for interpolation
-    //fs_Col = ((u_Transforms[0][3]) + vec4(1, 1, 1, 1)) * 0.5;
+    //fs_Col = ((jointMatrix(4 * u_JointOffset)[3]) + vec4(1, 1, 1, 1)) * 0.5;
     //fs_Col = vec4(heatMap(vs_Weights.r), 1);
     //fs_Col = vec4(vs_Weights.xy, 0.5, 1);
 
+    // blend the joints' skinning matrices by weight. a vertex that isn't
+    // bound to anything (e.g. one added by subdividing after skinning) stays put
+    mat4 skin = mat4(0);
+    int base = u_JointOffset + gl_InstanceID * u_JointsPerInstance;
+    for (int i = 0; i < 4; i++) {
+        skin += vs_Weights[i] * jointMatrix(4 * (base + int(vs_Ids[i])));
+    }
+    if (vs_Weights.x == 0.0) {
+        skin = mat4(1);
+    }
+
     mat3 invTranspose = mat3(u_ModelInvTr);
-    fs_Nor = vec4(invTranspose * vec3(vs_Nor), 0);          // Pass the vertex normals to the fragment shader for interpolation.
+    fs_Nor = vec4(invTranspose * (mat3(skin) * vec3(vs_Nor)), 0); // Pass the vertex normals to the fragment shader for interpolation.
                                                             // Transform the geometry's normals by the inverse transpose of the
                                                             // model matrix. This is necessary to ensure the normals remain
                                                             // perpendicular to the surface after the surface is transformed by
                                                             // the model matrix.
 
 
-    vec4 jointAPos = u_Transforms[vs_Ids.x] * u_Binds[vs_Ids.x] * vs_Pos;
-    vec4 jointBPos = u_Transforms[vs_Ids.y] * u_Binds[vs_Ids.y] * vs_Pos;
-    //vec4 modelposition = vs_Weights.x * jointAPos + vs_Weights.y * jointBPos;
-    vec4 modelposition = 1 * jointAPos + 0 * jointBPos;
+    vec4 modelposition = skin * vs_Pos;
 
     fs_Pos = modelposition.xyz;
 
@@ -0,0 +1,75 @@
+#version 150
+// Dual quaternion version of skeleton.vert.glsl. Blending the joints' rotations as
+// quaternions instead of blending their matrices keeps the mesh's volume where joints
+// twist or bend sharply, where linear blending collapses it.
+
+uniform mat4 u_Model;       // The matrix that defines the transformation of the
+                            // object we're rendering. In this assignment,
+                            // this will be the result of traversing your scene graph.
+
+uniform mat4 u_ModelInvTr;  // The inverse transpose of the model matrix.
+
+uniform mat4 u_ViewProj;    // The matrix that defines the camera's transformation.
+
+uniform samplerBuffer u_JointMatrices; // every skeleton's skinning transforms this frame as dual
+                                       // quaternions, see JointPalette. joint i's real part is
+                                       // texel 2i and its dual part texel 2i + 1
+uniform int u_JointOffset;             // where this mesh's skeleton starts in u_JointMatrices
+uniform int u_JointsPerInstance;       // how far apart instances' skeletons are when drawn instanced
+
+in vec4 vs_Pos;             // The array of vertex positions passed to the shader
+
+in vec4 vs_Nor;             // The array of vertex normals passed to the shader
+
+in vec4 vs_Col;             // The array of vertex colors passed to the shader.
+
+in uvec4 vs_Ids;            // ids of up to 4 joints, heaviest first
+in vec4 vs_Weights;         // their weights, unorm16 so they arrive in [0, 1] and sum to 1.
+                            // unused slots have weight 0, unbound vertices all 0
+
+out vec3 fs_Pos;
+out vec4 fs_Nor;            // The array of normals that has been transformed by u_ModelInvTr. This is implicitly passed to the fragment shader.
+out vec4 fs_Col;            // The color of each vertex. This is implicitly passed to the fragment shader.
+
+// rotates v by the unit quaternion q
+vec3 rotate(vec4 q, vec3 v) {
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main()
+{
+    fs_Col = vs_Col;                         // Pass the vertex colors to the fragment shader for interpolation
+
+    // blend the joints' dual quaternions by weight. q and -q are the same
+    // rotation, so each one is flipped onto the heaviest one's side first or
+    // the blend can cancel itself out
+    vec4 real = vec4(0, 0, 0, 1);
+    vec4 dual = vec4(0);
+    if (vs_Weights.x != 0.0) {
+        real = vec4(0);
+        int base = u_JointOffset + gl_InstanceID * u_JointsPerInstance;
+        vec4 pivot = texelFetch(u_JointMatrices, 2 * (base + int(vs_Ids.x)));
+        for (int i = 0; i < 4; i++) {
+            int texel = 2 * (base + int(vs_Ids[i]));
+            vec4 r = texelFetch(u_JointMatrices, texel);
+            float w = dot(r, pivot) < 0.0 ? -vs_Weights[i] : vs_Weights[i];
+            real += w * r;
+            dual += w * texelFetch(u_JointMatrices, texel + 1);
+        }
+        float len = length(real);
+        real /= len;
+        dual /= len;
+    }
+
+    // translation is 2 * dual * conjugate(real)
+    vec3 translation = 2.0 * (real.w * dual.xyz - dual.w * real.xyz + cross(real.xyz, dual.xyz));
+    vec4 modelposition = vec4(rotate(real, vs_Pos.xyz) + translation, 1);
+
+    mat3 invTranspose = mat3(u_ModelInvTr);
+    fs_Nor = vec4(invTranspose * rotate(real, vec3(vs_Nor)), 0);
+
+    fs_Pos = modelposition.xyz;
+
+    gl_Position = u_ViewProj * modelposition;// gl_Position is a built-in variable of OpenGL which is
+                                             // used to render the final positions of the geometry's vertices
+}
@@ -0,0 +1,27 @@
+# the core only needs qt for json and the la.h conversions, no widgets or opengl
+QT = core gui
+
+TARGET = meshbatch
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG += c++1z
+CONFIG += warn_on
+
+INCLUDEPATH += include
+
+# both targets build from one tree, so keep the shared core's objects apart
+OBJECTS_DIR = .obj/meshbatch
+
+include(src/core.pri)
+
+SOURCES += src/batch/meshbatch.cpp
+
+*-clang*|*-g++* {
+    CONFIG -= warn_on
+    QMAKE_CXXFLAGS += -Wall -Wextra -pedantic -Winit-self
+    QMAKE_CXXFLAGS += -Wno-strict-aliasing
+}
+unix {
+    LIBS += -lpthread
+}
@@ -0,0 +1,32 @@
+# benchmarks for the mesh core, see src/bench/meshbench.cpp. links the gl
+# drawables too so Mesh::create can be timed against a real context
+QT += core gui widgets openglwidgets
+
+TARGET = meshbench
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG += c++1z
+CONFIG += warn_on
+
+INCLUDEPATH += include
+
+OBJECTS_DIR = .obj/meshbench
+MOC_DIR = .moc/meshbench
+
+include(src/core.pri)
+include(src/gl.pri)
+
+SOURCES += src/bench/meshbench.cpp
+
+win32 {
+    LIBS += -lopengl32 -lpsapi
+}
+*-clang*|*-g++* {
+    CONFIG -= warn_on
+    QMAKE_CXXFLAGS += -Wall -Wextra -pedantic -Winit-self
+    QMAKE_CXXFLAGS += -Wno-strict-aliasing
+}
+unix {
+    LIBS += -lpthread
+}
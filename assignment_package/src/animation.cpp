@@ -0,0 +1,154 @@
+#include "animation.h"
+#include <trace.h>
+#include <algorithm>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+AnimationClip::AnimationClip()
+    : name(), duration(0.f),
+      rotOffsets(1, 0), rotTimes(), rotValues(),
+      posOffsets(1, 0), posTimes(), posValues()
+{}
+
+int AnimationClip::numJoints() const {
+    return int(rotOffsets.size()) - 1;
+}
+
+bool AnimationClip::isEmpty() const {
+    return rotTimes.empty() && posTimes.empty();
+}
+
+//the key to interpolate from for time t in the track [begin, end), and how
+//far t is towards the key after it. times outside the keys clamp to the
+//first or last one
+static uint32_t findKey(const std::vector<float>& times, uint32_t begin, uint32_t end, float t, float& blend) {
+    blend = 0.f;
+    uint32_t after = std::upper_bound(times.begin() + begin, times.begin() + end, t) - times.begin();
+    if (after == begin) {
+        return begin;
+    }
+    if (after == end) {
+        return end - 1;
+    }
+    uint32_t k = after - 1;
+    float span = times[after] - times[k];
+    blend = span > 0.f ? (t - times[k]) / span : 0.f;
+    return k;
+}
+
+glm::quat AnimationClip::sampleRotation(int j, float t) const {
+    float blend;
+    uint32_t k = findKey(rotTimes, rotOffsets[j], rotOffsets[j + 1], t, blend);
+    return blend > 0.f ? glm::slerp(rotValues[k], rotValues[k + 1], blend) : rotValues[k];
+}
+
+glm::vec3 AnimationClip::samplePosition(int j, float t) const {
+    float blend;
+    uint32_t k = findKey(posTimes, posOffsets[j], posOffsets[j + 1], t, blend);
+    return blend > 0.f ? glm::mix(posValues[k], posValues[k + 1], blend) : posValues[k];
+}
+
+void AnimationClip::evaluate(float t, SkeletonPose& pose) const {
+    trace::Zone traceZone("AnimationClip::evaluate", "animation");
+    traceZone.arg("joints", numJoints());
+    for (int j = 0; j < numJoints(); j++) {
+        if (rotOffsets[j] != rotOffsets[j + 1]) {
+            pose.setRotation(j, sampleRotation(j, t));
+        }
+        if (posOffsets[j] != posOffsets[j + 1]) {
+            pose.setPosition(j, samplePosition(j, t));
+        }
+    }
+}
+
+void AnimationClip::evaluate(float t, glm::vec3* positions, glm::quat* rotations) const {
+    for (int j = 0; j < numJoints(); j++) {
+        if (rotOffsets[j] != rotOffsets[j + 1]) {
+            rotations[j] = sampleRotation(j, t);
+        }
+        if (posOffsets[j] != posOffsets[j + 1]) {
+            positions[j] = samplePosition(j, t);
+        }
+    }
+}
+
+//one joint's keys while loading, before they're flattened into the clip
+struct TrackKeys {
+    std::vector<std::pair<float, glm::quat>> rot;
+    std::vector<std::pair<float, glm::vec3>> pos;
+};
+
+bool loadAnimationJSON(const std::string& path, const Skeleton& skeleton, AnimationClip& out, std::string& error) {
+    out = AnimationClip();
+    QFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        error = "could not read " + path;
+        return false;
+    }
+    QJsonDocument json = QJsonDocument::fromJson(file.readAll());
+    QJsonObject animation = json.object()["animation"].toObject();
+    if (animation.isEmpty()) {
+        error = path + " has no animation";
+        return false;
+    }
+
+    std::vector<TrackKeys> joints(skeleton.numJoints());
+    QJsonArray tracks = animation["tracks"].toArray();
+    for (int i = 0; i < tracks.size(); i++) {
+        QJsonObject track = tracks[i].toObject();
+        std::string jointName = track["joint"].toString().toStdString();
+        auto found = std::find(skeleton.names.begin(), skeleton.names.end(), jointName);
+        if (found == skeleton.names.end()) {
+            error = path + " animates " + jointName + ", which the skeleton doesn't have";
+            return false;
+        }
+        TrackKeys& keys = joints[found - skeleton.names.begin()];
+
+        QJsonArray rot = track["rot"].toArray(), pos = track["pos"].toArray();
+        for (int k = 0; k < rot.size(); k++) {
+            QJsonArray key = rot[k].toArray();
+            glm::vec3 axis = glm::vec3(key[2].toDouble(), key[3].toDouble(), key[4].toDouble());
+            keys.rot.push_back({float(key[0].toDouble()),
+                                glm::quat(glm::angleAxis(float(key[1].toDouble()), glm::normalize(axis)))});
+        }
+        for (int k = 0; k < pos.size(); k++) {
+            QJsonArray key = pos[k].toArray();
+            keys.pos.push_back({float(key[0].toDouble()),
+                                glm::vec3(key[1].toDouble(), key[2].toDouble(), key[3].toDouble())});
+        }
+    }
+
+    //flatten joint by joint so each joint's keys end up contiguous and in order
+    auto byTime = [](const auto& a, const auto& b) { return a.first < b.first; };
+    float lastKey = 0.f;
+    out.rotOffsets.clear();
+    out.posOffsets.clear();
+    for (TrackKeys& keys : joints) {
+        std::stable_sort(keys.rot.begin(), keys.rot.end(), byTime);
+        std::stable_sort(keys.pos.begin(), keys.pos.end(), byTime);
+        out.rotOffsets.push_back(out.rotTimes.size());
+        out.posOffsets.push_back(out.posTimes.size());
+        for (const auto& key : keys.rot) {
+            out.rotTimes.push_back(key.first);
+            out.rotValues.push_back(key.second);
+            lastKey = std::max(lastKey, key.first);
+        }
+        for (const auto& key : keys.pos) {
+            out.posTimes.push_back(key.first);
+            out.posValues.push_back(key.second);
+            lastKey = std::max(lastKey, key.first);
+        }
+    }
+    out.rotOffsets.push_back(out.rotTimes.size());
+    out.posOffsets.push_back(out.posTimes.size());
+
+    out.name = animation["name"].toString().toStdString();
+    out.duration = animation.contains("duration") ? float(animation["duration"].toDouble()) : lastKey;
+    if (out.isEmpty()) {
+        error = path + " has an animation with no keys";
+        return false;
+    }
+    return true;
+}
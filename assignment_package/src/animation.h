@@ -0,0 +1,51 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <skeleton.h>
+#include <string>
+#include <vector>
+
+//keyframed joint animation for one skeleton. every joint's keys sit in a
+//few flat arrays (struct of arrays), joint j's rotation keys are
+//[rotOffsets[j], rotOffsets[j + 1]) in rotTimes and rotValues and the same
+//for translations, so posing the whole skeleton walks each array once from
+//front to back. a joint with no keys of a kind keeps its rest value
+struct AnimationClip {
+    std::string name;
+    float duration;
+
+    std::vector<uint32_t> rotOffsets; //numJoints() + 1 of them
+    std::vector<float> rotTimes;
+    std::vector<glm::quat> rotValues;
+
+    std::vector<uint32_t> posOffsets;
+    std::vector<float> posTimes;
+    std::vector<glm::vec3> posValues; //relative to the parent, like Skeleton::positions
+
+    AnimationClip();
+
+    //joints of the skeleton the clip was loaded for
+    int numJoints() const;
+    bool isEmpty() const;
+
+    //poses every keyed joint at time t, clamped to the keys. rotations are
+    //slerped and translations lerped between the keys around t
+    void evaluate(float t, SkeletonPose& pose) const;
+    //same, into flat per joint arrays. unkeyed joints are left as they are
+    void evaluate(float t, glm::vec3* positions, glm::quat* rotations) const;
+
+private:
+    glm::quat sampleRotation(int j, float t) const;
+    glm::vec3 samplePosition(int j, float t) const;
+};
+
+//reads the "animation" object of a json file, which can be a skeleton json
+//with an animation added or a file of its own:
+//{"animation": {"name", "duration", "tracks": [{"joint": name,
+//  "rot": [[t, angle, x, y, z], ...], "pos": [[t, x, y, z], ...]}, ...]}}
+//tracks name joints of skeleton, rotations are the skeleton json's
+//angle-axis and the duration defaults to the last key. on failure returns
+//false and puts the reason in error
+bool loadAnimationJSON(const std::string& path, const Skeleton& skeleton, AnimationClip& out, std::string& error);
+
+#endif // ANIMATION_H
@@ -0,0 +1,187 @@
+#include <halfedgemesh.h>
+#include <meshcache.h>
+#include <objloader.h>
+#include <skeleton.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+//headless front end to the mesh core for asset pipelines. the steps after
+//the input file run left to right on one mesh, each one timed, e.g.
+//  meshbatch wolf.obj --subdivide 2 --skin wolf_skeleton.json --write wolf.mmesh
+
+static void usage() {
+    std::printf("usage: meshbatch <input.obj|input.mmesh> [steps...]\n"
+                "steps run in the order given:\n"
+                "  --subdivide N          N levels of Catmull-Clark subdivision\n"
+                "  --triangulate          fan triangulate every face\n"
+                "  --influences N         joints per vertex for the skin steps after it, 1 to 4 (default 4)\n"
+                "  --skin <skeleton.json> bind each vertex to its nearest joints\n"
+                "  --skin-bones <skeleton.json>  bind each vertex to the joints of its nearest bones\n"
+                "  --write <out.obj|out.mmesh>\n"
+                "  --stats                print element counts\n");
+}
+
+static bool endsWith(const std::string& s, const char* suffix) {
+    size_t n = std::strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+static bool load(const std::string& path, HalfEdgeMesh& mesh, std::string& error) {
+    if (endsWith(path, ".mmesh")) {
+        return MeshCache::read(path, mesh, error);
+    }
+    ObjData obj;
+    if (!loadOBJ(path, obj, error)) {
+        return false;
+    }
+    mesh = HalfEdgeMesh(obj.positions, obj.normals, obj.faceOffsets, obj.faceIndices);
+    if (mesh.numNonManifoldEdges() > 0) {
+        std::printf("  warning: %d non-manifold edges, %d boundary edges\n",
+                    mesh.numNonManifoldEdges(), mesh.numBoundaryEdges());
+    }
+    return true;
+}
+
+//normals are the input file's. after subdividing the new vertices don't have
+//one and the old ones no longer match the surface, so they're left out of
+//the obj for whatever reads it to compute. triangulating keeps them valid
+static bool write(const std::string& path, const HalfEdgeMesh& mesh, bool withNormals, std::string& error) {
+    if (endsWith(path, ".mmesh")) {
+        return MeshCache::write(mesh, path, error);
+    }
+    ObjData obj;
+    obj.positions.resize(mesh.numVertices());
+    for (int v = 0; v < mesh.numVertices(); v++) {
+        obj.positions[v] = mesh.getPos(VertexHandle(v));
+    }
+    if (withNormals) {
+        obj.normals.resize(mesh.numVertices());
+        for (int v = 0; v < mesh.numVertices(); v++) {
+            obj.normals[v] = mesh.getNor(VertexHandle(v));
+        }
+    }
+    mesh.getFaces(obj.faceOffsets, obj.faceIndices);
+    return writeOBJ(path, obj, error);
+}
+
+//a whole, non-negative number, so a typo isn't quietly read as 0
+static bool parseCount(const char* arg, int& out) {
+    char* end = nullptr;
+    long n = std::strtol(arg, &end, 10);
+    if (end == arg || *end != '\0' || n < 0 || n > 1000000) {
+        return false;
+    }
+    out = int(n);
+    return true;
+}
+
+static bool skin(const std::string& path, bool toBones, int maxInfluences, HalfEdgeMesh& mesh, std::string& error) {
+    Skeleton skeleton;
+    if (!loadSkeletonJSON(path, skeleton, error)) {
+        return false;
+    }
+    //influences store joint ids as uint16s
+    if (skeleton.numJoints() > 65536) {
+        error = path + ": " + std::to_string(skeleton.numJoints()) + " joints, skinning takes at most 65536";
+        return false;
+    }
+    std::vector<int> ids(skeleton.numJoints());
+    for (int j = 0; j < skeleton.numJoints(); j++) {
+        ids[j] = j;
+    }
+    if (toBones) {
+        mesh.bindNearestBones(skeleton.worldPositions(), skeleton.parents, ids, maxInfluences);
+    } else {
+        mesh.bindNearestJoints(skeleton.worldPositions(), ids, maxInfluences);
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 || argv[1][0] == '-') {
+        usage();
+        return 2;
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now(), stepStart = start;
+    HalfEdgeMesh mesh;
+    std::string error;
+    int maxInfluences = HalfEdgeMesh::MAX_INFLUENCES;
+    bool subdivided = false;
+
+    auto finishStep = [&](const std::string& step) {
+        Clock::time_point now = Clock::now();
+        std::printf("%-40s %10.2f ms  verts %d  faces %d\n", step.c_str(),
+                    std::chrono::duration<double, std::milli>(now - stepStart).count(),
+                    mesh.numVertices(), mesh.numFaces());
+        std::fflush(stdout);
+        stepStart = now;
+    };
+
+    std::string input = argv[1];
+    if (!load(input, mesh, error)) {
+        std::fprintf(stderr, "meshbatch: %s\n", error.c_str());
+        return 1;
+    }
+    finishStep("load " + input);
+
+    for (int i = 2; i < argc; i++) {
+        std::string step = argv[i];
+        bool hasArg = i + 1 < argc;
+        bool ok = true;
+
+        if (step == "--subdivide" && hasArg) {
+            int levels = 0;
+            if (!parseCount(argv[++i], levels)) {
+                std::fprintf(stderr, "meshbatch: --subdivide takes a number of levels, got %s\n", argv[i]);
+                return 2;
+            }
+            for (int l = 0; l < levels; l++) {
+                mesh.catmullclarkSubdivision();
+            }
+            subdivided = subdivided || levels > 0;
+            step += std::string(" ") + argv[i];
+        } else if (step == "--triangulate") {
+            int numFaces = mesh.numFaces();
+            for (int f = 0; f < numFaces; f++) {
+                mesh.triangulateFace(FaceHandle(f));
+            }
+        } else if (step == "--influences" && hasArg) {
+            if (!parseCount(argv[++i], maxInfluences) ||
+                maxInfluences < 1 || maxInfluences > HalfEdgeMesh::MAX_INFLUENCES) {
+                std::fprintf(stderr, "meshbatch: --influences takes 1 to %d\n", HalfEdgeMesh::MAX_INFLUENCES);
+                return 2;
+            }
+            continue;
+        } else if ((step == "--skin" || step == "--skin-bones") && hasArg) {
+            ok = skin(argv[++i], step == "--skin-bones", maxInfluences, mesh, error);
+            step += std::string(" ") + argv[i];
+        } else if (step == "--write" && hasArg) {
+            ok = write(argv[++i], mesh, !subdivided, error);
+            step += std::string(" ") + argv[i];
+        } else if (step == "--stats") {
+            std::printf("  %d verts, %d half-edges, %d faces, %d boundary edges, %d non-manifold edges\n",
+                        mesh.numVertices(), mesh.numHes(), mesh.numFaces(),
+                        mesh.numBoundaryEdges(), mesh.numNonManifoldEdges());
+            continue;
+        } else {
+            std::fprintf(stderr, "meshbatch: bad step %s\n", step.c_str());
+            usage();
+            return 2;
+        }
+
+        if (!ok) {
+            std::fprintf(stderr, "meshbatch: %s\n", error.c_str());
+            return 1;
+        }
+        finishStep(step);
+    }
+
+    std::printf("%-40s %10.2f ms\n", "total",
+                std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    return 0;
+}
@@ -0,0 +1,491 @@
+#include <halfedgemesh.h>
+#include <mesh.h>
+#include <objloader.h>
+#include <parallel.h>
+
+#include <QApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSurfaceFormat>
+#include <QTimer>
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <memory>
+#include <new>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+//benchmarks for the mesh core. every operation runs a few times on the
+//bundled obj files and on generated tori of growing size, and reports its
+//time, heap allocations and peak rss. results go to json so
+//runs from different commits can be compared with --baseline
+
+//every heap allocation in the process goes through here so an operation's
+//allocations can be read off as the difference between two snapshots
+static std::atomic<unsigned long long> g_allocs(0), g_allocBytes(0);
+
+void* operator new(std::size_t size) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_allocBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_allocBytes.fetch_add(size, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+//resets the high-water mark peakRssKB reads, so it only covers what runs
+//after. linux only, and only where /proc/self/clear_refs is writable
+static bool resetPeakRss() {
+#ifdef __linux__
+    FILE* file = std::fopen("/proc/self/clear_refs", "w");
+    if (!file) {
+        return false;
+    }
+    bool written = std::fputs("5", file) >= 0;
+    return std::fclose(file) == 0 && written;
+#else
+    return false;
+#endif
+}
+
+//peak resident set size in KB since the last resetPeakRss(), or over the
+//process' whole lifetime where that can't be reset
+static long peakRssKB() {
+#ifdef __linux__
+    if (FILE* file = std::fopen("/proc/self/status", "r")) {
+        char line[256];
+        long kb = -1;
+        while (kb < 0 && std::fgets(line, sizeof(line), file)) {
+            std::sscanf(line, "VmHWM: %ld kB", &kb);
+        }
+        std::fclose(file);
+        if (kb >= 0) {
+            return kb;
+        }
+    }
+#endif
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return long(counters.PeakWorkingSetSize / 1024);
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return long(usage.ru_maxrss / 1024);
+#else
+    return long(usage.ru_maxrss);
+#endif
+#endif
+}
+
+struct Options {
+    QString objDir;
+    std::vector<int> torusSizes = {64, 256, 1024};
+    int reps = 5;
+    QString outPath = "meshbench.json";
+    QString baselinePath;
+    double threshold = 10.0;
+    QString label;
+    bool gl = true;
+};
+
+struct Result {
+    QString mesh;
+    QString op;
+    int verts, faces;
+    std::vector<double> ms;
+    unsigned long long allocs, allocBytes;
+    //largest rss while op ran, which includes whatever was already resident.
+    //process wide if the high-water mark couldn't be reset before each rep
+    long peakRss;
+    bool peakRssPerOp;
+
+    double median() const {
+        std::vector<double> sorted = ms;
+        std::sort(sorted.begin(), sorted.end());
+        return sorted[sorted.size() / 2];
+    }
+};
+
+class Bench {
+public:
+    explicit Bench(const Options& options) : options(options), context(nullptr) {}
+
+    void setContext(OpenGLContext* ctx) {
+        context = ctx;
+    }
+
+    void run();
+    bool write() const;
+    //true if no operation got slower than the baseline by more than the threshold
+    bool compare() const;
+
+private:
+    Options options;
+    OpenGLContext* context;
+    std::vector<Result> results;
+
+    void benchMesh(const QString& name, const QString& objPath);
+
+    //times op reps times. setup runs before each rep and isn't measured,
+    //allocations are averaged over the reps
+    void measure(const QString& mesh, const QString& opName, const HalfEdgeMesh& sizeOf,
+                 const std::function<void()>& setup, const std::function<void()>& op);
+};
+
+void Bench::measure(const QString& mesh, const QString& opName, const HalfEdgeMesh& sizeOf,
+                    const std::function<void()>& setup, const std::function<void()>& op) {
+    typedef std::chrono::steady_clock Clock;
+    Result result;
+    result.mesh = mesh;
+    result.op = opName;
+    result.verts = sizeOf.numVertices();
+    result.faces = sizeOf.numFaces();
+    result.allocs = 0;
+    result.allocBytes = 0;
+    result.peakRss = 0;
+    result.peakRssPerOp = true;
+
+    for (int r = 0; r < options.reps; r++) {
+        setup();
+        //after setup, so its memory only counts if it's still resident
+        result.peakRssPerOp = resetPeakRss() && result.peakRssPerOp;
+        unsigned long long allocs = g_allocs.load(), bytes = g_allocBytes.load();
+        Clock::time_point start = Clock::now();
+        op();
+        result.ms.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        result.allocs += g_allocs.load() - allocs;
+        result.allocBytes += g_allocBytes.load() - bytes;
+        result.peakRss = std::max(result.peakRss, peakRssKB());
+    }
+    result.allocs /= options.reps;
+    result.allocBytes /= options.reps;
+
+    std::printf("%-22s %-14s %9d %9d %11.3f %11.3f %10llu %12llu %10ld%s\n",
+                mesh.toStdString().c_str(), opName.toStdString().c_str(), result.verts, result.faces,
+                *std::min_element(result.ms.begin(), result.ms.end()), result.median(),
+                result.allocs, result.allocBytes, result.peakRss, result.peakRssPerOp ? "" : " (process)");
+    std::fflush(stdout);
+    results.push_back(result);
+}
+
+//a closed n x n torus of quads
+static void writeTorus(int n, const QString& path) {
+    const float PI = 3.1415926535f;
+    ObjData obj;
+    obj.faceOffsets.push_back(0);
+    for (int i = 0; i < n; i++) {
+        float u = 2.f * PI * i / n;
+        for (int j = 0; j < n; j++) {
+            float v = 2.f * PI * j / n;
+            float r = 1.f + 0.3f * std::cos(v);
+            obj.positions.push_back(glm::vec3(r * std::cos(u), 0.3f * std::sin(v), r * std::sin(u)));
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            int i1 = (i + 1) % n, j1 = (j + 1) % n;
+            obj.faceIndices.insert(obj.faceIndices.end(), {uint32_t(i * n + j), uint32_t(i * n + j1),
+                                                           uint32_t(i1 * n + j1), uint32_t(i1 * n + j)});
+            obj.faceOffsets.push_back(obj.faceIndices.size());
+        }
+    }
+    std::string error;
+    writeOBJ(path.toStdString(), obj, error);
+}
+
+//a chain of joints through the mesh's bounding box, standing in for a rig
+static void chainJoints(const HalfEdgeMesh& mesh, int numJoints, std::vector<glm::vec3>& pos, std::vector<int>& ids) {
+    glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+    for (int v = 0; v < mesh.numVertices(); v++) {
+        lo = glm::min(lo, mesh.getPos(VertexHandle(v)));
+        hi = glm::max(hi, mesh.getPos(VertexHandle(v)));
+    }
+    for (int j = 0; j < numJoints; j++) {
+        pos.push_back(glm::mix(lo, hi, (j + 0.5f) / numJoints));
+        ids.push_back(j);
+    }
+}
+
+void Bench::benchMesh(const QString& name, const QString& objPath) {
+    std::string path = objPath.toStdString(), error;
+    ObjData obj;
+    if (!loadOBJ(path, obj, error)) {
+        std::printf("skipping %s: %s\n", name.toStdString().c_str(), error.c_str());
+        return;
+    }
+    HalfEdgeMesh base(obj.positions, obj.normals, obj.faceOffsets, obj.faceIndices);
+    HalfEdgeMesh work;
+
+    //what MyGL::readMesh does, parse and build the connectivity
+    measure(name, "readMesh", base, [&]() {
+        obj = ObjData();
+    }, [&]() {
+        loadOBJ(path, obj, error);
+        work = HalfEdgeMesh(obj.positions, obj.normals, obj.faceOffsets, obj.faceIndices);
+    });
+
+    if (context) {
+        std::unique_ptr<Mesh> mesh;
+        measure(name, "create", base, [&]() {
+            mesh.reset(new Mesh(context, obj.positions, obj.normals, obj.faceOffsets, obj.faceIndices));
+        }, [&]() {
+            mesh->create();
+        });
+        mesh.reset();
+    }
+
+    measure(name, "catmullclark", base, [&]() {
+        work = base;
+    }, [&]() {
+        work.catmullclarkSubdivision();
+    });
+
+    measure(name, "triangulate", base, [&]() {
+        work = base;
+    }, [&]() {
+        for (int f = 0; f < base.numFaces(); f++) {
+            work.triangulateFace(FaceHandle(f));
+        }
+    });
+
+    measure(name, "extrude", base, [&]() {
+        work = base;
+    }, [&]() {
+        for (int f = 0; f < base.numFaces(); f++) {
+            work.extrudeFace(FaceHandle(f));
+        }
+    });
+
+    //the binding pass Mesh::skinMesh runs, against a 16 joint chain
+    std::vector<glm::vec3> jointPos;
+    std::vector<int> jointIds;
+    chainJoints(base, 16, jointPos, jointIds);
+    measure(name, "skinMesh", base, [&]() {
+        work = base;
+    }, [&]() {
+        work.bindNearestJoints(jointPos, jointIds);
+    });
+}
+
+void Bench::run() {
+    std::printf("%-22s %-14s %9s %9s %11s %11s %10s %12s %10s\n",
+                "mesh", "op", "verts", "faces", "min ms", "median ms", "allocs", "alloc bytes", "peak KB");
+
+    for (const char* file : {"cube.obj", "dodecahedron.obj", "wolf.obj", "cow.obj"}) {
+        benchMesh(file, QDir(options.objDir).filePath(file));
+    }
+    for (int n : options.torusSizes) {
+        QString name = QString("torus_%1").arg(n);
+        QString path = QDir(QDir::tempPath()).filePath("meshbench_" + name + ".obj");
+        writeTorus(n, path);
+        benchMesh(name, path);
+        QFile::remove(path);
+    }
+}
+
+bool Bench::write() const {
+    QJsonArray rows;
+    for (const Result& r : results) {
+        QJsonArray ms;
+        for (double t : r.ms) {
+            ms.append(t);
+        }
+        QJsonObject row;
+        row["mesh"] = r.mesh;
+        row["op"] = r.op;
+        row["verts"] = r.verts;
+        row["faces"] = r.faces;
+        row["ms"] = ms;
+        row["minMs"] = *std::min_element(r.ms.begin(), r.ms.end());
+        row["medianMs"] = r.median();
+        row["allocs"] = double(r.allocs);
+        row["allocBytes"] = double(r.allocBytes);
+        row["peakRssKB"] = double(r.peakRss);
+        row["peakRssScope"] = r.peakRssPerOp ? "op" : "process";
+        rows.append(row);
+    }
+
+    QJsonObject root;
+    root["label"] = options.label;
+    root["date"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    root["threads"] = parallel::numThreads();
+    root["reps"] = options.reps;
+    root["gl"] = context != nullptr;
+    root["results"] = rows;
+
+    QFile file(options.outPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        std::printf("could not write %s\n", options.outPath.toStdString().c_str());
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson());
+    std::printf("wrote %s\n", options.outPath.toStdString().c_str());
+    return true;
+}
+
+bool Bench::compare() const {
+    QFile file(options.baselinePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        std::printf("could not read baseline %s\n", options.baselinePath.toStdString().c_str());
+        return false;
+    }
+    QJsonObject baseline = QJsonDocument::fromJson(file.readAll()).object();
+    std::map<std::pair<QString, QString>, double> before;
+    for (const QJsonValue& row : baseline["results"].toArray()) {
+        QJsonObject r = row.toObject();
+        before[{r["mesh"].toString(), r["op"].toString()}] = r["medianMs"].toDouble();
+    }
+
+    std::printf("\ncompared to %s (%s)\n", options.baselinePath.toStdString().c_str(),
+                baseline["label"].toString().toStdString().c_str());
+    int regressions = 0;
+    for (const Result& r : results) {
+        auto found = before.find({r.mesh, r.op});
+        if (found == before.end() || found->second <= 0.0) {
+            continue;
+        }
+        double change = 100.0 * (r.median() - found->second) / found->second;
+        //sub-50us operations are mostly timer noise
+        bool regressed = change > options.threshold && r.median() - found->second > 0.05;
+        regressions += regressed;
+        std::printf("%-22s %-14s %11.3f -> %11.3f ms %+8.1f%%%s\n",
+                    r.mesh.toStdString().c_str(), r.op.toStdString().c_str(),
+                    found->second, r.median(), change, regressed ? "  REGRESSION" : "");
+    }
+    std::printf("%d regression%s over %.0f%%\n", regressions, regressions == 1 ? "" : "s", options.threshold);
+    return regressions == 0;
+}
+
+//the bench needs a live gl context for Mesh::create, which a qt widget only
+//has once it's been shown, so the whole run happens in initializeGL
+class BenchContext : public OpenGLContext {
+public:
+    BenchContext(Bench& bench) : OpenGLContext(nullptr), bench(bench) {}
+
+    void initializeGL() override {
+        initializeOpenGLFunctions();
+        bench.setContext(this);
+        bench.run();
+        QTimer::singleShot(0, qApp, &QApplication::quit);
+    }
+
+private:
+    Bench& bench;
+};
+
+static void usage() {
+    std::printf("usage: meshbench [options]\n"
+                "  --objs <dir>         where cube/dodecahedron/wolf/cow.obj are (default: search up from here)\n"
+                "  --sizes 64,256,1024  generated torus resolutions\n"
+                "  --reps N             runs per operation (default 5)\n"
+                "  --out <file.json>    results file (default meshbench.json)\n"
+                "  --label <text>       stored in the results, e.g. a commit hash\n"
+                "  --baseline <file>    compare medians against an earlier run\n"
+                "  --threshold <pct>    slowdown that counts as a regression (default 10)\n"
+                "  --no-gl              skip Mesh::create, for machines without a gl context\n");
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    for (const char* dir : {"obj_files", "../obj_files", "../../obj_files"}) {
+        if (QDir(dir).exists()) {
+            options.objDir = dir;
+            break;
+        }
+    }
+    for (int i = 1; i < argc; i++) {
+        QString arg = argv[i];
+        bool hasArg = i + 1 < argc;
+        if (arg == "--objs" && hasArg) {
+            options.objDir = argv[++i];
+        } else if (arg == "--sizes" && hasArg) {
+            options.torusSizes.clear();
+            for (const QString& n : QString(argv[++i]).split(',')) {
+                options.torusSizes.push_back(n.toInt());
+            }
+        } else if (arg == "--reps" && hasArg) {
+            options.reps = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--out" && hasArg) {
+            options.outPath = argv[++i];
+        } else if (arg == "--label" && hasArg) {
+            options.label = argv[++i];
+        } else if (arg == "--baseline" && hasArg) {
+            options.baselinePath = argv[++i];
+        } else if (arg == "--threshold" && hasArg) {
+            options.threshold = atof(argv[++i]);
+        } else if (arg == "--no-gl") {
+            options.gl = false;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    Bench bench(options);
+    QApplication app(argc, argv);
+    if (options.gl) {
+        //same context the app asks for in main.cpp
+        QSurfaceFormat format;
+        format.setVersion(3, 2);
+        format.setOption(QSurfaceFormat::DeprecatedFunctions, false);
+        format.setProfile(QSurfaceFormat::CoreProfile);
+        QSurfaceFormat::setDefaultFormat(format);
+
+        BenchContext context(bench);
+        context.resize(64, 64);
+        context.show();
+        app.exec();
+        bench.setContext(nullptr);
+    } else {
+        bench.run();
+    }
+
+    if (!bench.write()) {
+        return 1;
+    }
+    if (!options.baselinePath.isEmpty() && !bench.compare()) {
+        return 1;
+    }
+    return 0;
+}
@@ -1,91 +1,44 @@
 #ifndef COMPONENT_H
 #define COMPONENT_H
 
-#include "joint.h"
-#include "qlistwidget.h"
-#include <la.h>
+#include <cstdint>
+#include <functional>
 
-class Vertex;
-class HalfEdge;
-class Face;
+//value used by every handle and connectivity array to mean "no element"
+static const uint32_t INVALID_IDX = 0xFFFFFFFF;
 
-class HalfEdge : public QListWidgetItem {
-private:
-    HalfEdge* next;
-    HalfEdge* sym;
-    Face* face;
-    Vertex* v;
-    int id;
-public:
-    HalfEdge();
-    ~HalfEdge();
-    static int topId;
-    void setSym(HalfEdge* he);
-    void setFace(Face* f);
-    void setVertex(Vertex* v);
-    void setNext(HalfEdge* he);
-    Vertex* getVertex() const;
-    HalfEdge* getNext() const;
-    HalfEdge* getSym() const;
-    Face* getFace() const;
-    int getId() const;
+//a typed 32-bit index into one of HalfEdgeMesh's element arrays. the tag
+//type only exists so a vertex index can't be passed where a face is expected
+template <typename Tag>
+struct Handle {
+    uint32_t idx;
 
-    friend class Vertex;
-    friend class Face;
-    friend class Mesh;
-};
-
-class Vertex : public QListWidgetItem {
-private:
-    glm::vec3 pos;
-    glm::vec3 nor;
-    HalfEdge* he;
-    int id;
-
-    //added for hw7
-    std::vector<std::pair<Joint*, float>> influences;
-public:
-    Vertex();
-    Vertex(Vertex&);
-    ~Vertex();
-    static int topId;
-    glm::vec3 getPos() const;
-    int getId() const;
-    HalfEdge* getHE() const;
+    Handle() : idx(INVALID_IDX) {}
+    explicit Handle(uint32_t i) : idx(i) {}
 
-    void setX(float x);
-    void setY(float y);
-    void setZ(float z);
+    bool isValid() const { return idx != INVALID_IDX; }
 
-    void addInfluence(Joint* j, float weight);
-    std::vector<std::pair<Joint*, float>>& getInfluences();
-
-    friend class HalfEdge;
-    friend class Face;
-    friend class Mesh;
-    friend class VertexDisplay;
+    bool operator==(const Handle& other) const { return idx == other.idx; }
+    bool operator!=(const Handle& other) const { return idx != other.idx; }
+    bool operator<(const Handle& other) const { return idx < other.idx; }
 };
 
-class Face : public QListWidgetItem {
-private:
-    HalfEdge* he;
-    glm::vec3 color;
-    int id;
-public:
-    Face();
-    ~Face();
-    static int topId;
-    void setEdge(HalfEdge* he);
-    glm::vec3 getColor() const;
-    HalfEdge* getHE() const;
-
-    void setR(float r);
-    void setG(float g);
-    void setB(float b);
-
-    friend class HalfEdge;
-    friend class Vertex;
-    friend class Mesh;
+struct VertexTag {};
+struct HalfEdgeTag {};
+struct FaceTag {};
+
+typedef Handle<VertexTag> VertexHandle;
+typedef Handle<HalfEdgeTag> HalfEdgeHandle;
+typedef Handle<FaceTag> FaceHandle;
+
+//lets handles be used as keys in unordered containers
+namespace std {
+template <typename Tag>
+struct hash<Handle<Tag>> {
+    std::size_t operator () (const Handle<Tag>& h) const {
+        return std::hash<uint32_t>{}(h.idx);
+    }
 };
+}
 
 #endif // COMPONENT_H
@@ -0,0 +1,33 @@
+# the mesh core: geometry, file formats and skinning with no widgets or gl,
+# shared by the app and the meshbatch tool
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+SOURCES += \
+    $$PWD/animation.cpp \
+    $$PWD/crowd.cpp \
+    $$PWD/halfedgemesh.cpp \
+    $$PWD/la.cpp \
+    $$PWD/mappedfile.cpp \
+    $$PWD/meshcache.cpp \
+    $$PWD/objloader.cpp \
+    $$PWD/skeleton.cpp \
+    $$PWD/stenciltable.cpp \
+    $$PWD/threadpool.cpp \
+    $$PWD/trace.cpp
+
+HEADERS += \
+    $$PWD/animation.h \
+    $$PWD/component.h \
+    $$PWD/crowd.h \
+    $$PWD/halfedgemesh.h \
+    $$PWD/la.h \
+    $$PWD/mappedfile.h \
+    $$PWD/meshcache.h \
+    $$PWD/objloader.h \
+    $$PWD/parallel.h \
+    $$PWD/radixsort.h \
+    $$PWD/skeleton.h \
+    $$PWD/stenciltable.h \
+    $$PWD/threadpool.h \
+    $$PWD/trace.h
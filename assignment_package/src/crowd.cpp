@@ -0,0 +1,90 @@
+#include "crowd.h"
+#include <trace.h>
+#include <cmath>
+
+Crowd::Crowd()
+    : parents(), restPositions(), restRotations(), binds(), clip(nullptr),
+      models(), times(), speeds(), palette()
+{}
+
+void Crowd::setSkeleton(const Skeleton& skeleton, const std::vector<glm::mat4>& binds) {
+    parents = skeleton.parents;
+    restPositions = skeleton.positions;
+    restRotations = skeleton.rotations;
+    this->binds = binds;
+    clip = nullptr;
+    clear();
+}
+
+void Crowd::setClip(const AnimationClip* clip) {
+    this->clip = clip;
+}
+
+void Crowd::scatter(int count, float spacing) {
+    clear();
+    int side = int(std::ceil(std::sqrt(float(count))));
+    float start = -0.5f * spacing * (side - 1);
+    for (int i = 0; i < count; i++) {
+        glm::vec3 pos(start + spacing * (i % side), 0.f, start + spacing * (i / side));
+        models.push_back(glm::translate(glm::mat4(), pos));
+        //golden ratio steps spread the start times without neighbors lining up
+        float phase = std::fmod(i * 0.618034f, 1.f);
+        times.push_back(phase * (clip ? clip->duration : 0.f));
+        speeds.push_back(0.85f + 0.3f * std::fmod(i * 0.381966f, 1.f));
+    }
+    palette.assign(count * numJoints(), glm::mat4());
+}
+
+void Crowd::clear() {
+    models.clear();
+    times.clear();
+    speeds.clear();
+    palette.clear();
+}
+
+int Crowd::numInstances() const {
+    return models.size();
+}
+
+int Crowd::numJoints() const {
+    return parents.size();
+}
+
+void Crowd::update(float dt, ThreadPool& pool) {
+    trace::Zone traceZone("Crowd::update", "animation");
+    traceZone.arg("instances", numInstances());
+    int numJoints = this->numJoints();
+    //a few instances per task keeps the queues short without starving
+    //threads on small crowds
+    const int PER_TASK = 8;
+    int tasks = (numInstances() + PER_TASK - 1) / PER_TASK;
+    pool.run(tasks, [&](int task) {
+        //scratch kept per thread so posing doesn't allocate
+        thread_local std::vector<glm::vec3> positions;
+        thread_local std::vector<glm::quat> rotations;
+        int end = std::min(numInstances(), (task + 1) * PER_TASK);
+        for (int i = task * PER_TASK; i < end; i++) {
+            positions.assign(restPositions.begin(), restPositions.end());
+            rotations.assign(restRotations.begin(), restRotations.end());
+            if (clip && clip->duration > 0.f) {
+                times[i] = std::fmod(times[i] + dt * speeds[i], clip->duration);
+                clip->evaluate(times[i], positions.data(), rotations.data());
+            }
+
+            //parents come first, so one pass builds every world transform
+            //in place, then a second one applies the binds
+            glm::mat4* out = &palette[i * numJoints];
+            for (int j = 0; j < numJoints; j++) {
+                glm::mat4 local = glm::translate(glm::mat4(), positions[j]) * glm::toMat4(rotations[j]);
+                out[j] = (parents[j] < 0 ? models[i] : out[parents[j]]) * local;
+            }
+            for (int j = 0; j < numJoints; j++) {
+                out[j] = out[j] * binds[j];
+            }
+        }
+    });
+}
+
+const std::vector<glm::mat4>& Crowd::getPalette() const {
+    return palette;
+}
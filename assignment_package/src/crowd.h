@@ -0,0 +1,51 @@
+#ifndef CROWD_H
+#define CROWD_H
+
+#include <animation.h>
+#include <threadpool.h>
+#include <vector>
+
+//many copies of one skinned character. instances share the skeleton's
+//hierarchy, rest pose and bind matrices and only keep a placement and a
+//clip time of their own. each update poses every instance on a thread pool
+//and writes its skinning matrices (model * world * bind) straight into one
+//packed palette, instance i's joints starting at i * numJoints(), which is
+//the layout an instanced draw reads with gl_InstanceID
+class Crowd {
+public:
+    Crowd();
+
+    //binds are the inverse bind matrices the mesh was skinned with
+    void setSkeleton(const Skeleton& skeleton, const std::vector<glm::mat4>& binds);
+    //the clip every instance plays, or null to hold the rest pose. has to
+    //outlive the crowd or be replaced first
+    void setClip(const AnimationClip* clip);
+    //count instances on a square grid spacing apart around the origin, each
+    //starting the clip at a different time and playing it at its own speed
+    void scatter(int count, float spacing);
+    void clear();
+
+    int numInstances() const;
+    int numJoints() const;
+
+    //advances every instance dt seconds and rebuilds the palette
+    void update(float dt, ThreadPool& pool);
+    const std::vector<glm::mat4>& getPalette() const;
+
+private:
+    //shared by every instance
+    std::vector<int> parents;
+    std::vector<glm::vec3> restPositions;
+    std::vector<glm::quat> restRotations;
+    std::vector<glm::mat4> binds;
+    const AnimationClip* clip;
+
+    //per instance
+    std::vector<glm::mat4> models;
+    std::vector<float> times;
+    std::vector<float> speeds;
+
+    std::vector<glm::mat4> palette;
+};
+
+#endif // CROWD_H
@@ -2,8 +2,7 @@
 #include <la.h>
 
 Drawable::Drawable(OpenGLContext* context)
-    : count(-1), bufIdx(), bufPos(), bufNor(), bufCol(),
-      idxBound(false), posBound(false), norBound(false), colBound(false),
+    : count(-1), bufIdx(), bufPos(), bufNor(), bufCol(), bufIds(), bufWeights(), vecSize(4),
       mp_context(context)
 {}
 
@@ -14,12 +13,17 @@ Drawable::~Drawable() {
 
 void Drawable::destroy()
 {
-    mp_context->glDeleteBuffers(1, &bufIdx);
-    mp_context->glDeleteBuffers(1, &bufPos);
-    mp_context->glDeleteBuffers(1, &bufNor);
-    mp_context->glDeleteBuffers(1, &bufCol);
-    mp_context->glDeleteBuffers(1, &bufWeights);
-    mp_context->glDeleteBuffers(1, &bufIds);
+    bufIdx.reset();
+    bufPos.reset();
+    bufNor.reset();
+    bufCol.reset();
+    bufWeights.reset();
+    bufIds.reset();
+}
+
+void Drawable::upload(GLBuffer& buf, const void* data, GLsizeiptr bytes, GLenum usage)
+{
+    mp_context->getBufferPool().upload(buf, data, bytes, usage);
 }
 
 GLenum Drawable::drawMode()
@@ -38,90 +42,61 @@ int Drawable::elemCount()
     return count;
 }
 
-void Drawable::generateIdx()
-{
-    idxBound = true;
-    // Create a VBO on our GPU and store its handle in bufIdx
-    mp_context->glGenBuffers(1, &bufIdx);
-}
-
-void Drawable::generatePos()
-{
-    posBound = true;
-    // Create a VBO on our GPU and store its handle in bufPos
-    mp_context->glGenBuffers(1, &bufPos);
-}
-
-void Drawable::generateNor()
-{
-    norBound = true;
-    // Create a VBO on our GPU and store its handle in bufNor
-    mp_context->glGenBuffers(1, &bufNor);
-}
-
-void Drawable::generateCol()
-{
-    colBound = true;
-    // Create a VBO on our GPU and store its handle in bufCol
-    mp_context->glGenBuffers(1, &bufCol);
-}
-
-void Drawable::generateIds()
+int Drawable::attrSize()
 {
-    idsBound = true;
-    mp_context->glGenBuffers(1, &bufIds);
+    return vecSize;
 }
 
-void Drawable::generateWeights()
+GLsizeiptr Drawable::gpuBytes() const
 {
-    weightsBound = true;
-    mp_context->glGenBuffers(1, &bufWeights);
+    return bufIdx.capacity() + bufPos.capacity() + bufNor.capacity() + bufCol.capacity()
+         + bufIds.capacity() + bufWeights.capacity();
 }
 
 bool Drawable::bindIdx()
 {
-    if(idxBound) {
-        mp_context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufIdx);
+    if (!bufIdx.empty()) {
+        mp_context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufIdx.id());
     }
-    return idxBound;
+    return !bufIdx.empty();
 }
 
 bool Drawable::bindPos()
 {
-    if(posBound){
-        mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufPos);
+    if (!bufPos.empty()) {
+        mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufPos.id());
     }
-    return posBound;
+    return !bufPos.empty();
 }
 
 bool Drawable::bindNor()
 {
-    if(norBound){
-        mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufNor);
+    if (!bufNor.empty()) {
+        mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufNor.id());
     }
-    return norBound;
+    return !bufNor.empty();
 }
 
 bool Drawable::bindCol()
 {
-    if(colBound){
-        mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufCol);
+    if (!bufCol.empty()) {
+        mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufCol.id());
     }
-    return colBound;
+    return !bufCol.empty();
 }
 
 bool Drawable::bindIds()
 {
-    if (idsBound) {
-        mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufIds);
+    if (!bufIds.empty()) {
+        mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufIds.id());
     }
-    return idsBound;
+    return !bufIds.empty();
 }
 
 bool Drawable::bindWeights()
 {
-    if (weightsBound) {
-        mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufWeights);
+    if (!bufWeights.empty()) {
+        mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufWeights.id());
     }
-    return weightsBound;
+    return !bufWeights.empty();
 }
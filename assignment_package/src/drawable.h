@@ -2,6 +2,8 @@
 
 #include <openglcontext.h>
 #include <la.h>
+#include <glbuffer.h>
+#include <vector>
 
 //This defines a class which can be rendered by our shader program.
 //Make any geometry a subclass of ShaderProgram::Drawable in order to render it with the ShaderProgram class.
@@ -9,50 +11,50 @@ class Drawable
 {
 protected:
     int count;     // The number of indices stored in bufIdx.
-    GLuint bufIdx; // A Vertex Buffer Object that we will use to store triangle indices (GLuints)
-    GLuint bufPos; // A Vertex Buffer Object that we will use to store mesh vertices (vec4s)
-    GLuint bufNor; // A Vertex Buffer Object that we will use to store mesh normals (vec4s)
-    GLuint bufCol; // Can be used to pass per-vertex color information to the shader, but is currently unused.
-                   // Instead, we use a uniform vec4 in the shader to set an overall color for the geometry
+    GLBuffer bufIdx; // A Vertex Buffer Object that we will use to store triangle indices (GLuints)
+    GLBuffer bufPos; // A Vertex Buffer Object that we will use to store mesh vertices (vec4s)
+    GLBuffer bufNor; // A Vertex Buffer Object that we will use to store mesh normals (vec4s)
+    GLBuffer bufCol; // Can be used to pass per-vertex color information to the shader, but is currently unused.
+                     // Instead, we use a uniform vec4 in the shader to set an overall color for the geometry
 
-    GLuint bufIds; //hw 7 -- buffer for joint ids
-    GLuint bufWeights; //hw 7 -- buffer for joint weights
+    GLBuffer bufIds; //hw 7 -- buffer for joint ids
+    GLBuffer bufWeights; //hw 7 -- buffer for joint weights
 
-    bool idxBound; // Set to TRUE by generateIdx(), returned by bindIdx().
-    bool posBound;
-    bool norBound;
-    bool colBound;
-
-    bool idsBound;
-    bool weightsBound;
+    int vecSize; // Floats per vertex in bufPos, bufNor and bufCol. 4 unless a subclass packs them as vec3s,
+                 // the shader fills in the missing w with 1.
 
     OpenGLContext* mp_context; // Since Qt's OpenGL support is done through classes like QOpenGLFunctions_3_2_Core,
                           // we need to pass our OpenGL context to the Drawable in order to call GL functions
                           // from within this class.
 
+    // Fills one of the buffers above with bytes of data, taking a buffer from the context's pool the first
+    // time and reusing it (orphaned, so in-flight draws don't stall) for as long as the data still fits.
+    // Recreating a Drawable every frame therefore costs no new GPU memory.
+    void upload(GLBuffer& buf, const void* data, GLsizeiptr bytes, GLenum usage = GL_STATIC_DRAW);
+    template <class T>
+    void upload(GLBuffer& buf, const std::vector<T>& data, GLenum usage = GL_STATIC_DRAW) {
+        upload(buf, data.data(), data.size() * sizeof(T), usage);
+    }
+
 
 public:
     Drawable(OpenGLContext* context);
     virtual ~Drawable();
+    Drawable(Drawable&&) = default;
+    Drawable& operator=(Drawable&&) = default;
 
     virtual void create() = 0; // To be implemented by subclasses. Populates the VBOs of the Drawable.
-    void destroy(); // Frees the VBOs of the Drawable.
+    void destroy(); // Gives the VBOs of the Drawable back to the pool.
 
     // Getter functions for various GL data
     virtual GLenum drawMode();
     int elemCount();
+    int attrSize();
+    // Bytes of GPU buffer storage the Drawable holds right now
+    virtual GLsizeiptr gpuBytes() const;
 
-    // Call these functions when you want to call glGenBuffers on the buffers stored in the Drawable
-    // These will properly set the values of idxBound etc. which need to be checked in ShaderProgram::draw()
-    void generateIdx();
-    void generatePos();
-    void generateNor();
-    void generateCol();
-
-    //new funcs for hw7
-    void generateIds();
-    void generateWeights();
-
+    // Each of these binds its buffer and returns true if it has been uploaded,
+    // which is what ShaderProgram::draw() checks before using an attribute
     bool bindIdx();
     bool bindPos();
     bool bindNor();
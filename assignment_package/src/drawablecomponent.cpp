@@ -1,8 +1,7 @@
 #include "drawablecomponent.h"
 
-VertexDisplay::VertexDisplay() : Drawable(nullptr), representedVertex(nullptr) {}
-VertexDisplay::VertexDisplay(OpenGLContext *context, Vertex* v) : Drawable(context), representedVertex(v) {}
-VertexDisplay::~VertexDisplay() {}
+VertexDisplay::VertexDisplay() : Drawable(nullptr), mesh(nullptr), representedVertex() {}
+VertexDisplay::VertexDisplay(OpenGLContext *context, const HalfEdgeMesh* mesh, VertexHandle v) : Drawable(context), mesh(mesh), representedVertex(v) {}
 
 void VertexDisplay::create() {
     std::vector<glm::vec4> col;
@@ -10,25 +9,17 @@ void VertexDisplay::create() {
     std::vector<GLuint> idx;
 
     col.push_back(glm::vec4(1, 1, 1, 1));
-    pos.push_back(glm::vec4(representedVertex->pos, 1));
+    pos.push_back(glm::vec4(mesh->getPos(representedVertex), 1));
     idx.push_back(0);
 
     count = idx.size();
 
-    generateIdx();
-    mp_context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufIdx);
-    mp_context->glBufferData(GL_ELEMENT_ARRAY_BUFFER, idx.size() * sizeof(GLuint), idx.data(), GL_STATIC_DRAW);
-
-    generatePos();
-    mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufPos);
-    mp_context->glBufferData(GL_ARRAY_BUFFER, pos.size() * sizeof(glm::vec4), pos.data(), GL_STATIC_DRAW);
-
-    generateCol();
-    mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufCol);
-    mp_context->glBufferData(GL_ARRAY_BUFFER, col.size() * sizeof(glm::vec4), col.data(), GL_STATIC_DRAW);
+    upload(bufIdx, idx);
+    upload(bufPos, pos);
+    upload(bufCol, col);
 }
 
-void VertexDisplay::updateVertex(Vertex* v) {
+void VertexDisplay::updateVertex(VertexHandle v) {
     this->representedVertex = v;
 }
 
@@ -36,127 +27,97 @@ GLenum VertexDisplay::drawMode() {
     return GL_POINTS;
 }
 
-HalfEdge* VertexDisplay::getHE() const {
-    return this->representedVertex->getHE();
+HalfEdgeHandle VertexDisplay::getHE() const {
+    return mesh->getHE(representedVertex);
 }
 
-HalfEdgeDisplay::HalfEdgeDisplay() : Drawable(nullptr), representedHE(nullptr) {}
-HalfEdgeDisplay::HalfEdgeDisplay(OpenGLContext *context, HalfEdge* he) : Drawable(context), representedHE(he) {}
-HalfEdgeDisplay::~HalfEdgeDisplay() {}
+HalfEdgeDisplay::HalfEdgeDisplay() : Drawable(nullptr), mesh(nullptr), representedHE() {}
+HalfEdgeDisplay::HalfEdgeDisplay(OpenGLContext *context, const HalfEdgeMesh* mesh, HalfEdgeHandle he) : Drawable(context), mesh(mesh), representedHE(he) {}
 
 void HalfEdgeDisplay::create() {
     std::vector<glm::vec4> col;
     std::vector<glm::vec4> pos;
     std::vector<GLuint> idx;
 
-    Vertex* prevVert;
-    HalfEdge* iter = representedHE;
-    do {
-        prevVert = iter->getVertex();
-        iter = iter->getNext();
-    } while (iter != representedHE);
+    VertexHandle prevVert = mesh->getVertex(mesh->getPrev(representedHE));
 
     col.push_back(glm::vec4(1, 0, 0, 1));
     col.push_back(glm::vec4(1, 1, 0, 1));
-    pos.push_back(glm::vec4(prevVert->getPos(), 1));
-    pos.push_back(glm::vec4(representedHE->getVertex()->getPos(), 1));
+    pos.push_back(glm::vec4(mesh->getPos(prevVert), 1));
+    pos.push_back(glm::vec4(mesh->getPos(mesh->getVertex(representedHE)), 1));
     idx.push_back(0);
     idx.push_back(1);
 
     count = idx.size();
 
-    generateIdx();
-    mp_context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufIdx);
-    mp_context->glBufferData(GL_ELEMENT_ARRAY_BUFFER, idx.size() * sizeof(GLuint), idx.data(), GL_STATIC_DRAW);
-
-    generatePos();
-    mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufPos);
-    mp_context->glBufferData(GL_ARRAY_BUFFER, pos.size() * sizeof(glm::vec4), pos.data(), GL_STATIC_DRAW);
-
-    generateCol();
-    mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufCol);
-    mp_context->glBufferData(GL_ARRAY_BUFFER, col.size() * sizeof(glm::vec4), col.data(), GL_STATIC_DRAW);
+    upload(bufIdx, idx);
+    upload(bufPos, pos);
+    upload(bufCol, col);
 }
 
-void HalfEdgeDisplay::updateHE(HalfEdge* he) {
+void HalfEdgeDisplay::updateHE(HalfEdgeHandle he) {
     this->representedHE = he;
 }
 
 void HalfEdgeDisplay::makeNext() {
-    this->representedHE = this->representedHE->getNext();
+    this->representedHE = mesh->getNext(representedHE);
 }
 
 void HalfEdgeDisplay::makeSym() {
-    this->representedHE = this->representedHE->getSym();
+    //boundary hes of open meshes have no sym, stay on this one
+    HalfEdgeHandle sym = mesh->getSym(representedHE);
+    if (sym.isValid()) {
+        this->representedHE = sym;
+    }
 }
 
 GLenum HalfEdgeDisplay::drawMode() {
     return GL_LINES;
 }
 
-Face* HalfEdgeDisplay::getFace() const {
-    return this->representedHE->getFace();
+FaceHandle HalfEdgeDisplay::getFace() const {
+    return mesh->getFace(representedHE);
 }
 
-Vertex* HalfEdgeDisplay::getVertex() const {
-    return this->representedHE->getVertex();
+VertexHandle HalfEdgeDisplay::getVertex() const {
+    return mesh->getVertex(representedHE);
 }
 
-FaceDisplay::FaceDisplay() : Drawable(nullptr), representedFace(nullptr) {}
-FaceDisplay::FaceDisplay(OpenGLContext *context, Face* f) : Drawable(context), representedFace(f) {}
-FaceDisplay::~FaceDisplay() {}
-
-Vertex* getPrevVert(HalfEdge* he) {
-    Vertex* prevVert;
-    HalfEdge* iter = he;
-    do {
-        prevVert = iter->getVertex();
-        iter = iter->getNext();
-    } while (iter != he);
-    return prevVert;
-}
+FaceDisplay::FaceDisplay() : Drawable(nullptr), mesh(nullptr), representedFace() {}
+FaceDisplay::FaceDisplay(OpenGLContext *context, const HalfEdgeMesh* mesh, FaceHandle f) : Drawable(context), mesh(mesh), representedFace(f) {}
 
 void FaceDisplay::create() {
     std::vector<glm::vec4> col;
     std::vector<glm::vec4> pos;
     std::vector<GLuint> idx;
 
-    std::vector<HalfEdge*> hes;
-    HalfEdge* iter = representedFace->getHE();
-    do {
-        hes.push_back(iter);
-        iter = iter->getNext();
-    } while (iter != representedFace->getHE());
-
+    //walking the loop once gives each edge's start vertex for free,
+    //it's the end vertex of the edge before it
+    HalfEdgeHandle start = mesh->getHE(representedFace);
+    VertexHandle prev = mesh->getVertex(mesh->getPrev(start));
+    HalfEdgeHandle iter = start;
     int counter = 0;
-    for (HalfEdge* hePtr : hes) {
+    do {
+        VertexHandle next = mesh->getVertex(iter);
         col.push_back(glm::vec4(1, 0, 0, 1));
         col.push_back(glm::vec4(1, 1, 0, 1));
-        Vertex* prev = getPrevVert(hePtr);
-        Vertex* next = hePtr->getVertex();
-        pos.push_back(glm::vec4(prev->getPos(), 1));
-        pos.push_back(glm::vec4(next->getPos(), 1));
+        pos.push_back(glm::vec4(mesh->getPos(prev), 1));
+        pos.push_back(glm::vec4(mesh->getPos(next), 1));
         idx.push_back(counter);
         idx.push_back(counter + 1);
         counter += 2;
-    }
+        prev = next;
+        iter = mesh->getNext(iter);
+    } while (iter != start);
 
     count = idx.size();
 
-    generateIdx();
-    mp_context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufIdx);
-    mp_context->glBufferData(GL_ELEMENT_ARRAY_BUFFER, idx.size() * sizeof(GLuint), idx.data(), GL_STATIC_DRAW);
-
-    generatePos();
-    mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufPos);
-    mp_context->glBufferData(GL_ARRAY_BUFFER, pos.size() * sizeof(glm::vec4), pos.data(), GL_STATIC_DRAW);
-
-    generateCol();
-    mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufCol);
-    mp_context->glBufferData(GL_ARRAY_BUFFER, col.size() * sizeof(glm::vec4), col.data(), GL_STATIC_DRAW);
+    upload(bufIdx, idx);
+    upload(bufPos, pos);
+    upload(bufCol, col);
 }
 
-void FaceDisplay::updateFace(Face* f) {
+void FaceDisplay::updateFace(FaceHandle f) {
     this->representedFace = f;
 }
 
@@ -164,6 +125,6 @@ GLenum FaceDisplay::drawMode() {
     return GL_LINES;
 }
 
-HalfEdge* FaceDisplay::getHE() const {
-    return this->representedFace->getHE();
+HalfEdgeHandle FaceDisplay::getHE() const {
+    return mesh->getHE(representedFace);
 }
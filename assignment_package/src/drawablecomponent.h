@@ -2,69 +2,65 @@
 #define DRAWABLECOMPONENT_H
 
 #include <drawable.h>
-#include "component.h"
+#include "halfedgemesh.h"
 
 class VertexDisplay : public Drawable {
 protected:
-    Vertex *representedVertex;
+    const HalfEdgeMesh *mesh;
+    VertexHandle representedVertex;
 
 public:
     VertexDisplay();
-    VertexDisplay(OpenGLContext *context, Vertex*);
-    ~VertexDisplay();
+    VertexDisplay(OpenGLContext *context, const HalfEdgeMesh* mesh, VertexHandle);
     // Creates VBO data to make a visual
     // representation of the currently selected Vertex
     void create() override;
-    // Change which Vertex representedVertex points to
-    void updateVertex(Vertex*);
+    // Change which Vertex representedVertex refers to
+    void updateVertex(VertexHandle);
     GLenum drawMode() override;
 
-    HalfEdge* getHE() const;
-
-    friend class Vertex;
+    //invalid for a vertex no face uses
+    HalfEdgeHandle getHE() const;
 };
 
 class HalfEdgeDisplay : public Drawable {
 protected:
-    HalfEdge *representedHE;
+    const HalfEdgeMesh *mesh;
+    HalfEdgeHandle representedHE;
 
 public:
     HalfEdgeDisplay();
-    HalfEdgeDisplay(OpenGLContext *context, HalfEdge*);
-    ~HalfEdgeDisplay();
+    HalfEdgeDisplay(OpenGLContext *context, const HalfEdgeMesh* mesh, HalfEdgeHandle);
     // Creates VBO data to make a visual
     // representation of the currently selected HalfEdge
     void create() override;
-    // Change which HalfEdge representedHE points to
-    void updateHE(HalfEdge*);
+    // Change which HalfEdge representedHE refers to
+    void updateHE(HalfEdgeHandle);
     void makeNext();
+    //no-op on a boundary he, which has no sym
     void makeSym();
     GLenum drawMode() override;
 
-    Face* getFace() const;
-    Vertex* getVertex() const;
-
-    friend class HalfEdge;
+    FaceHandle getFace() const;
+    VertexHandle getVertex() const;
 };
 
 class FaceDisplay : public Drawable {
 protected:
-    Face *representedFace;
+    const HalfEdgeMesh *mesh;
+    FaceHandle representedFace;
 
 public:
     FaceDisplay();
-    FaceDisplay(OpenGLContext *context, Face*);
-    ~FaceDisplay();
+    FaceDisplay(OpenGLContext *context, const HalfEdgeMesh* mesh, FaceHandle);
     // Creates VBO data to make a visual
     // representation of the currently selected Face
     void create() override;
-    // Change which Face representedFace points to
-    void updateFace(Face*);
+    // Change which Face representedFace refers to
+    void updateFace(FaceHandle);
     GLenum drawMode() override;
 
-    HalfEdge* getHE() const;
-
-    friend class Face;
+    HalfEdgeHandle getHE() const;
 };
 
 #endif // DRAWABLECOMPONENT_H
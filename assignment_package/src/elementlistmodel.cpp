@@ -0,0 +1,40 @@
+#include "elementlistmodel.h"
+
+ElementListModel::ElementListModel(const QString &label, QObject *parent)
+    : QAbstractListModel(parent), label(label), count(0)
+{}
+
+void ElementListModel::setCount(int n) {
+    if (n == count) {
+        return;
+    }
+    if (n < count) {
+        reset(n);
+        return;
+    }
+    //mesh operators only ever append elements, so existing rows stay valid
+    beginInsertRows(QModelIndex(), count, n - 1);
+    count = n;
+    endInsertRows();
+}
+
+void ElementListModel::reset(int n) {
+    beginResetModel();
+    count = n;
+    endResetModel();
+}
+
+int ElementListModel::rowCount(const QModelIndex &parent) const {
+    //flat list, no row has children
+    if (parent.isValid()) {
+        return 0;
+    }
+    return count;
+}
+
+QVariant ElementListModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= count || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    return label + QString::number(index.row() + 1);
+}
@@ -0,0 +1,29 @@
+#ifndef ELEMENTLISTMODEL_H
+#define ELEMENTLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QString>
+
+//list model for one kind of mesh element. it only stores how many elements
+//there are and builds each row's text on demand, so a million faces costs
+//nothing until the view actually scrolls a row into sight
+class ElementListModel : public QAbstractListModel {
+    Q_OBJECT
+private:
+    QString label; //text each row starts with, e.g. "Face - "
+    int count;
+
+public:
+    ElementListModel(const QString &label, QObject *parent = nullptr);
+
+    // Grows the list in place when elements were only appended (edits keep the
+    // selection and scroll position), otherwise resets it
+    void setCount(int n);
+    // Throws away every row, used when a different mesh is loaded
+    void reset(int n);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+};
+
+#endif // ELEMENTLISTMODEL_H
@@ -0,0 +1,21 @@
+# the mesh and joint drawables and the gl context they upload through, on
+# top of the core. shared by the app and the meshbench tool
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+SOURCES += \
+    $$PWD/drawable.cpp \
+    $$PWD/glbuffer.cpp \
+    $$PWD/joint.cpp \
+    $$PWD/mesh.cpp \
+    $$PWD/openglcontext.cpp \
+    $$PWD/utils.cpp
+
+HEADERS += \
+    $$PWD/drawable.h \
+    $$PWD/glbuffer.h \
+    $$PWD/joint.h \
+    $$PWD/mesh.h \
+    $$PWD/openglcontext.h \
+    $$PWD/smartpointerhelp.h \
+    $$PWD/utils.h
@@ -0,0 +1,144 @@
+#include "glbuffer.h"
+#include "openglcontext.h"
+#include <trace.h>
+#include <utility>
+
+GLBuffer::GLBuffer() : pool(nullptr), buf(0), bytes(0), used(0) {}
+
+GLBuffer::~GLBuffer() {
+    reset();
+}
+
+GLBuffer::GLBuffer(GLBuffer&& other) noexcept
+    : pool(other.pool), buf(other.buf), bytes(other.bytes), used(other.used)
+{
+    other.pool = nullptr;
+    other.buf = 0;
+    other.bytes = other.used = 0;
+}
+
+GLBuffer& GLBuffer::operator=(GLBuffer&& other) noexcept {
+    if (this != &other) {
+        reset();
+        std::swap(pool, other.pool);
+        std::swap(buf, other.buf);
+        std::swap(bytes, other.bytes);
+        std::swap(used, other.used);
+    }
+    return *this;
+}
+
+bool GLBuffer::empty() const {
+    return buf == 0;
+}
+
+GLuint GLBuffer::id() const {
+    return buf;
+}
+
+GLsizeiptr GLBuffer::capacity() const {
+    return bytes;
+}
+
+GLsizeiptr GLBuffer::size() const {
+    return used;
+}
+
+void GLBuffer::reset() {
+    if (pool) {
+        pool->release(*this);
+    }
+    pool = nullptr;
+    buf = 0;
+    bytes = used = 0;
+}
+
+BufferPool::BufferPool(OpenGLContext* context)
+    : mp_context(context), freeBuffers(), inUse(0), free(0), numInUse(0)
+{}
+
+int BufferPool::sizeClass(GLsizeiptr bytes) {
+    int k = 0;
+    while (classBytes(k) < bytes) {
+        k++;
+    }
+    return k;
+}
+
+GLsizeiptr BufferPool::classBytes(int k) {
+    return MIN_BYTES << k;
+}
+
+GLBuffer BufferPool::acquire(GLsizeiptr bytes) {
+    int k = sizeClass(bytes);
+    GLBuffer out;
+    out.pool = this;
+    out.bytes = classBytes(k);
+    if (k < int(freeBuffers.size()) && !freeBuffers[k].empty()) {
+        out.buf = freeBuffers[k].back();
+        freeBuffers[k].pop_back();
+        free -= out.bytes;
+    } else {
+        //the store itself is made by the upload that asked for the buffer
+        mp_context->glGenBuffers(1, &out.buf);
+    }
+    inUse += out.bytes;
+    numInUse++;
+    return out;
+}
+
+void BufferPool::release(GLBuffer& buf) {
+    int k = sizeClass(buf.bytes);
+    if (k >= int(freeBuffers.size())) {
+        freeBuffers.resize(k + 1);
+    }
+    freeBuffers[k].push_back(buf.buf);
+    inUse -= buf.bytes;
+    free += buf.bytes;
+    numInUse--;
+}
+
+void BufferPool::upload(GLBuffer& buf, const void* data, GLsizeiptr bytes, GLenum usage) {
+    trace::Zone traceZone("BufferPool::upload", "gpu");
+    traceZone.arg("bytes", int64_t(bytes));
+    if (buf.empty() || buf.bytes < bytes) {
+        buf = acquire(bytes);
+    }
+    //the copy target isn't part of the vao, so index buffers can be filled
+    //without disturbing the bound element array
+    mp_context->glBindBuffer(GL_COPY_WRITE_BUFFER, buf.buf);
+    if (bytes == buf.bytes) {
+        mp_context->glBufferData(GL_COPY_WRITE_BUFFER, bytes, data, usage);
+    } else {
+        //respecifying the whole store orphans the old one, a new buffer
+        //gets its store this way too
+        mp_context->glBufferData(GL_COPY_WRITE_BUFFER, buf.bytes, nullptr, usage);
+        if (data && bytes > 0) {
+            mp_context->glBufferSubData(GL_COPY_WRITE_BUFFER, 0, bytes, data);
+        }
+    }
+    mp_context->glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    buf.used = bytes;
+}
+
+void BufferPool::trim(GLsizeiptr keepBytes) {
+    for (int k = int(freeBuffers.size()) - 1; k >= 0 && free > keepBytes; k--) {
+        while (!freeBuffers[k].empty() && free > keepBytes) {
+            mp_context->glDeleteBuffers(1, &freeBuffers[k].back());
+            freeBuffers[k].pop_back();
+            free -= classBytes(k);
+        }
+    }
+}
+
+GLsizeiptr BufferPool::bytesInUse() const {
+    return inUse;
+}
+
+GLsizeiptr BufferPool::bytesFree() const {
+    return free;
+}
+
+int BufferPool::buffersInUse() const {
+    return numInUse;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <QOpenGLFunctions_3_2_Core>
+#include <vector>
+
+class OpenGLContext;
+class BufferPool;
+
+//a gl buffer object on loan from a BufferPool. the buffer goes back to the
+//pool when the handle is reset, assigned over or destroyed, so whatever
+//holds one can't leak it. move only, like a unique_ptr
+class GLBuffer {
+public:
+    GLBuffer();
+    ~GLBuffer();
+    GLBuffer(GLBuffer&& other) noexcept;
+    GLBuffer& operator=(GLBuffer&& other) noexcept;
+    GLBuffer(const GLBuffer&) = delete;
+    GLBuffer& operator=(const GLBuffer&) = delete;
+
+    bool empty() const;
+    GLuint id() const;
+    //bytes the buffer's store holds, its pool size class
+    GLsizeiptr capacity() const;
+    //bytes of it written by the last upload
+    GLsizeiptr size() const;
+
+    //hands the buffer back to its pool
+    void reset();
+
+private:
+    friend class BufferPool;
+
+    BufferPool* pool;
+    GLuint buf;
+    GLsizeiptr bytes;
+    GLsizeiptr used;
+};
+
+//every gl buffer a context's drawables use. stores come in power of two
+//size classes, and a buffer given back waits on its class' free list for
+//the next request that fits instead of being deleted, so rebuilding a
+//drawable every edit (or every frame) reuses the same few buffers. giving
+//one back never calls gl, only trim() deletes, so handles can die anywhere
+class BufferPool {
+public:
+    BufferPool(OpenGLContext* context);
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    //puts bytes of data in buf. a buffer that's big enough keeps its id and
+    //is orphaned and refilled, so draws still reading the old contents never
+    //stall the upload, anything smaller goes back for one that fits
+    void upload(GLBuffer& buf, const void* data, GLsizeiptr bytes, GLenum usage);
+    //deletes free buffers, largest first, until at most keepBytes are left
+    void trim(GLsizeiptr keepBytes = 0);
+
+    //bytes in buffers on loan and waiting on the free lists
+    GLsizeiptr bytesInUse() const;
+    GLsizeiptr bytesFree() const;
+    int buffersInUse() const;
+
+    //the smallest size class, a few vertices' worth
+    static const GLsizeiptr MIN_BYTES = 256;
+
+private:
+    friend class GLBuffer;
+
+    GLBuffer acquire(GLsizeiptr bytes);
+    void release(GLBuffer& buf);
+    //smallest class holding bytes, and the bytes class k holds
+    static int sizeClass(GLsizeiptr bytes);
+    static GLsizeiptr classBytes(int k);
+
+    OpenGLContext* mp_context;
+    std::vector<std::vector<GLuint>> freeBuffers; //by size class
+    GLsizeiptr inUse;
+    GLsizeiptr free;
+    int numInUse;
+};
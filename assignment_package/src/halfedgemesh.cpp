@@ -0,0 +1,1012 @@
+#include <halfedgemesh.h>
+#include <parallel.h>
+#include <radixsort.h>
+#include <trace.h>
+#include <cfloat>
+
+HalfEdgeMesh::HalfEdgeMesh() : topologyEdited(true), boundaryEdges(0), nonManifoldEdges(0) {}
+
+HalfEdgeMesh::HalfEdgeMesh(const std::vector<glm::vec3>& vertices, const std::vector<glm::vec3>& normals, const std::vector<std::vector<int>>& faces)
+    : topologyEdited(true), boundaryEdges(0), nonManifoldEdges(0)
+{
+    std::vector<uint32_t> faceOffsets(1, 0), faceIndices;
+    for (const std::vector<int>& face : faces) {
+        faceIndices.insert(faceIndices.end(), face.begin(), face.end());
+        faceOffsets.push_back(faceIndices.size());
+    }
+    build(vertices, normals, faceOffsets, faceIndices);
+}
+
+HalfEdgeMesh::HalfEdgeMesh(const std::vector<glm::vec3>& vertices, const std::vector<glm::vec3>& normals,
+                           const std::vector<uint32_t>& faceOffsets, const std::vector<uint32_t>& faceIndices)
+    : topologyEdited(true), boundaryEdges(0), nonManifoldEdges(0)
+{
+    build(vertices, normals, faceOffsets, faceIndices);
+}
+
+//a fixed pseudo-random color per face index (the integer hash from
+//murmur3's finalizer), so meshes come out the same no matter how many
+//threads built them or what else has called rand()
+static glm::vec3 faceColorFor(uint32_t f) {
+    uint32_t h = f + 0x9e3779b9u;
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return glm::vec3((h & 0x3ff) / 1023.f, ((h >> 10) & 0x3ff) / 1023.f, ((h >> 20) & 0x3ff) / 1023.f);
+}
+
+void HalfEdgeMesh::build(const std::vector<glm::vec3>& vertices, const std::vector<glm::vec3>& normals,
+                         const std::vector<uint32_t>& faceOffsets, const std::vector<uint32_t>& faceIndices) {
+    //every array gets sized once up front instead of growing element by element
+    int numVerts = vertices.size();
+    int totalHes = faceIndices.size();
+    int numFaces = faceOffsets.empty() ? 0 : faceOffsets.size() - 1;
+    trace::Zone traceZone("HalfEdgeMesh::build", "core");
+    traceZone.arg("faces", numFaces);
+    vertPos = vertices;
+    vertNor.assign(numVerts, glm::vec3());
+    std::copy(normals.begin(), normals.begin() + std::min<size_t>(normals.size(), numVerts), vertNor.begin());
+    vertHE.assign(numVerts, INVALID_IDX);
+    vertJointIds.assign(numVerts, glm::u16vec4());
+    vertJointWeights.assign(numVerts, glm::u16vec4());
+    faceHE.resize(numFaces);
+    faceColor.resize(numFaces);
+    heNext.resize(totalHes);
+    heSym.assign(totalHes, INVALID_IDX);
+    heFace.resize(totalHes);
+    heVert.resize(totalHes);
+
+    //a face's hes are contiguous and numbered in corner order, so each face
+    //fills in its own slots without looking at any other face
+    parallel::forEach(numFaces, [&](int f) {
+        uint32_t firstHE = faceOffsets[f];
+        int numEdges = faceOffsets[f + 1] - firstHE;
+        for (int i = 0; i < numEdges; ++i) {
+            uint32_t he = firstHE + i;
+            heVert[he] = faceIndices[firstHE + (i + 1) % numEdges];
+            heFace[he] = f;
+            heNext[he] = firstHE + (i + 1) % numEdges;
+        }
+        faceHE[f] = firstHE + numEdges - 1;
+        faceColor[f] = faceColorFor(f);
+    });
+
+    //each vertex points at the last he that ends on it
+    for (int he = 0; he < totalHes; he++) {
+        vertHE[heVert[he]] = he;
+    }
+
+    matchTwins(faceIndices);
+}
+
+void HalfEdgeMesh::matchTwins(const std::vector<uint32_t>& faceIndices) {
+    TRACE_ZONE("matchTwins", "core");
+    //he i runs from faceIndices[i] to heVert[i]. both hes of an edge get the
+    //same key, (smaller vertex, larger vertex), so sorting by key puts twins
+    //next to each other. the sort is stable so ties stay in he order
+    int totalHes = heVert.size();
+    uint64_t numVerts = vertPos.size();
+    std::vector<uint64_t> keys(totalHes);
+    std::vector<uint32_t> hes(totalHes);
+    parallel::forEach(totalHes, [&](int he) {
+        uint64_t a = faceIndices[he], b = heVert[he];
+        keys[he] = std::min(a, b) * numVerts + std::max(a, b);
+        hes[he] = he;
+    });
+    int keyBits = 0;
+    while (keyBits < 64 && (numVerts * numVerts) >> keyBits) {
+        keyBits++;
+    }
+    parallel::radixSortByKey(keys, hes, keyBits);
+
+    //one pass over the runs of equal keys
+    boundaryEdges = 0;
+    nonManifoldEdges = 0;
+    for (int i = 0; i < totalHes;) {
+        int end = i + 1;
+        while (end < totalHes && keys[end] == keys[i]) {
+            end++;
+        }
+
+        if (end - i == 1) {
+            boundaryEdges++;
+        } else if (end - i == 2 && heVert[hes[i]] != heVert[hes[i + 1]]) {
+            heSym[hes[i]] = hes[i + 1];
+            heSym[hes[i + 1]] = hes[i];
+        } else {
+            //more than two faces on the edge, or faces that disagree on
+            //winding. hes going opposite ways are paired off in order and
+            //whatever is left over is treated like a boundary
+            nonManifoldEdges++;
+            for (int j = i; j < end; j++) {
+                for (int k = j + 1; k < end && heSym[hes[j]] == INVALID_IDX; k++) {
+                    if (heSym[hes[k]] == INVALID_IDX && heVert[hes[j]] != heVert[hes[k]]) {
+                        heSym[hes[j]] = hes[k];
+                        heSym[hes[k]] = hes[j];
+                    }
+                }
+            }
+        }
+        i = end;
+    }
+}
+
+VertexHandle HalfEdgeMesh::addVertex(glm::vec3 pos) {
+    topologyEdited = true;
+    vertPos.push_back(pos);
+    vertNor.push_back(glm::vec3());
+    vertHE.push_back(INVALID_IDX);
+    vertJointIds.push_back(glm::u16vec4());
+    vertJointWeights.push_back(glm::u16vec4());
+    return VertexHandle(vertPos.size() - 1);
+}
+
+HalfEdgeHandle HalfEdgeMesh::addHE() {
+    topologyEdited = true;
+    heNext.push_back(INVALID_IDX);
+    heSym.push_back(INVALID_IDX);
+    heFace.push_back(INVALID_IDX);
+    heVert.push_back(INVALID_IDX);
+    return HalfEdgeHandle(heNext.size() - 1);
+}
+
+FaceHandle HalfEdgeMesh::addFace(glm::vec3 color) {
+    topologyEdited = true;
+    faceHE.push_back(INVALID_IDX);
+    faceColor.push_back(color);
+    return FaceHandle(faceHE.size() - 1);
+}
+
+int HalfEdgeMesh::numVertices() const {
+    return vertPos.size();
+}
+
+int HalfEdgeMesh::numHes() const {
+    return heNext.size();
+}
+
+int HalfEdgeMesh::numFaces() const {
+    return faceHE.size();
+}
+
+bool HalfEdgeMesh::hasVertices() const {
+    return !this->vertPos.empty();
+}
+
+void HalfEdgeMesh::getFaces(std::vector<uint32_t>& faceOffsets, std::vector<uint32_t>& faceIndices) const {
+    //valences first so every face knows where its corners go
+    faceOffsets.assign(numFaces() + 1, 0);
+    parallel::forEach(numFaces(), [&](int f) {
+        faceOffsets[f + 1] = getValence(FaceHandle(f));
+    });
+    for (int f = 0; f < numFaces(); f++) {
+        faceOffsets[f + 1] += faceOffsets[f];
+    }
+    faceIndices.resize(faceOffsets.back());
+    parallel::forEach(numFaces(), [&](int f) {
+        uint32_t he = faceHE[f], k = faceOffsets[f];
+        do {
+            faceIndices[k++] = heVert[he];
+            he = heNext[he];
+        } while (he != faceHE[f]);
+    });
+}
+
+int HalfEdgeMesh::numBoundaryEdges() const {
+    return boundaryEdges;
+}
+
+int HalfEdgeMesh::numNonManifoldEdges() const {
+    return nonManifoldEdges;
+}
+
+int HalfEdgeMesh::calcTotalIndices() const {
+    int num = 0;
+    for (int f = 0; f < numFaces(); f++) {
+        num += getValence(FaceHandle(f)) - 2;
+    }
+    return 3 * num;
+}
+
+HalfEdgeHandle HalfEdgeMesh::getNext(HalfEdgeHandle he) const {
+    return HalfEdgeHandle(heNext[he.idx]);
+}
+
+HalfEdgeHandle HalfEdgeMesh::getSym(HalfEdgeHandle he) const {
+    return HalfEdgeHandle(heSym[he.idx]);
+}
+
+FaceHandle HalfEdgeMesh::getFace(HalfEdgeHandle he) const {
+    return FaceHandle(heFace[he.idx]);
+}
+
+VertexHandle HalfEdgeMesh::getVertex(HalfEdgeHandle he) const {
+    return VertexHandle(heVert[he.idx]);
+}
+
+HalfEdgeHandle HalfEdgeMesh::getPrev(HalfEdgeHandle he) const {
+    uint32_t prev = he.idx;
+    while (heNext[prev] != he.idx) {
+        prev = heNext[prev];
+    }
+    return HalfEdgeHandle(prev);
+}
+
+void HalfEdgeMesh::setNext(HalfEdgeHandle he, HalfEdgeHandle next) {
+    topologyEdited = true;
+    heNext[he.idx] = next.idx;
+}
+
+void HalfEdgeMesh::setSym(HalfEdgeHandle he, HalfEdgeHandle sym) {
+    topologyEdited = true;
+    heSym[he.idx] = sym.idx;
+    heSym[sym.idx] = he.idx;
+}
+
+void HalfEdgeMesh::setFace(HalfEdgeHandle he, FaceHandle f) {
+    topologyEdited = true;
+    heFace[he.idx] = f.idx;
+    faceHE[f.idx] = he.idx;
+}
+
+void HalfEdgeMesh::setVertex(HalfEdgeHandle he, VertexHandle v) {
+    topologyEdited = true;
+    heVert[he.idx] = v.idx;
+}
+
+glm::vec3 HalfEdgeMesh::getPos(VertexHandle v) const {
+    return vertPos[v.idx];
+}
+
+glm::vec3 HalfEdgeMesh::getNor(VertexHandle v) const {
+    return vertNor[v.idx];
+}
+
+HalfEdgeHandle HalfEdgeMesh::getHE(VertexHandle v) const {
+    return HalfEdgeHandle(vertHE[v.idx]);
+}
+
+void HalfEdgeMesh::setPos(VertexHandle v, glm::vec3 pos) {
+    movePos(v, pos);
+}
+
+void HalfEdgeMesh::setX(VertexHandle v, float x) {
+    glm::vec3 pos = hasStencils() && v.idx < controlPos.size() ? controlPos[v.idx] : vertPos[v.idx];
+    pos.x = x;
+    movePos(v, pos);
+}
+
+void HalfEdgeMesh::setY(VertexHandle v, float y) {
+    glm::vec3 pos = hasStencils() && v.idx < controlPos.size() ? controlPos[v.idx] : vertPos[v.idx];
+    pos.y = y;
+    movePos(v, pos);
+}
+
+void HalfEdgeMesh::setZ(VertexHandle v, float z) {
+    glm::vec3 pos = hasStencils() && v.idx < controlPos.size() ? controlPos[v.idx] : vertPos[v.idx];
+    pos.z = z;
+    movePos(v, pos);
+}
+
+void HalfEdgeMesh::movePos(VertexHandle v, glm::vec3 pos) {
+    if (!hasStencils() || v.idx >= controlPos.size()) {
+        //refined vertices are only moved until the cage next touches them
+        vertPos[v.idx] = pos;
+        logVertex(v.idx);
+        return;
+    }
+    controlPos[v.idx] = pos;
+    if (topologyEdited) {
+        std::vector<uint32_t> rows;
+        stencils.evaluateColumn(controlPos, vertPos, v.idx, rows);
+    } else {
+        stencils.evaluateColumn(controlPos, vertPos, v.idx, editedVerts);
+    }
+}
+
+void HalfEdgeMesh::logVertex(uint32_t v) {
+    //once the topology changed everything gets rebuilt anyway
+    if (!topologyEdited) {
+        editedVerts.push_back(v);
+    }
+}
+
+void HalfEdgeMesh::logFace(uint32_t f) {
+    if (!topologyEdited) {
+        editedFaces.push_back(f);
+    }
+}
+
+bool HalfEdgeMesh::hasEdits() const {
+    return topologyEdited || !editedVerts.empty() || !editedFaces.empty();
+}
+
+bool HalfEdgeMesh::hasTopologyEdits() const {
+    return topologyEdited;
+}
+
+void HalfEdgeMesh::clearEdits() {
+    topologyEdited = false;
+    editedVerts.clear();
+    editedFaces.clear();
+}
+
+HalfEdgeHandle HalfEdgeMesh::getHE(FaceHandle f) const {
+    return HalfEdgeHandle(faceHE[f.idx]);
+}
+
+glm::vec3 HalfEdgeMesh::getColor(FaceHandle f) const {
+    return faceColor[f.idx];
+}
+
+int HalfEdgeMesh::getValence(FaceHandle f) const {
+    int numVerts = 0;
+    uint32_t start = faceHE[f.idx], loopHE = start;
+    do {
+        numVerts++;
+        loopHE = heNext[loopHE];
+    } while (loopHE != start);
+    return numVerts;
+}
+
+void HalfEdgeMesh::setColor(FaceHandle f, glm::vec3 color) {
+    logFace(f.idx);
+    faceColor[f.idx] = color;
+}
+
+void HalfEdgeMesh::setR(FaceHandle f, float r) {
+    logFace(f.idx);
+    faceColor[f.idx].r = r;
+}
+
+void HalfEdgeMesh::setG(FaceHandle f, float g) {
+    logFace(f.idx);
+    faceColor[f.idx].g = g;
+}
+
+void HalfEdgeMesh::setB(FaceHandle f, float b) {
+    logFace(f.idx);
+    faceColor[f.idx].b = b;
+}
+
+glm::ivec4 HalfEdgeMesh::getJointIds(VertexHandle v) const {
+    return glm::ivec4(vertJointIds[v.idx]);
+}
+
+glm::vec4 HalfEdgeMesh::getJointWeights(VertexHandle v) const {
+    return glm::vec4(vertJointWeights[v.idx]) / 65535.f;
+}
+
+int HalfEdgeMesh::numInfluences(VertexHandle v) const {
+    int n = 0;
+    while (n < MAX_INFLUENCES && vertJointWeights[v.idx][n] != 0) {
+        n++;
+    }
+    return n;
+}
+
+//sorts, prunes, renormalizes and quantizes one vertex's influences
+static void packInfluences(int count, const int* ids, const float* weights, float pruneBelow,
+                           glm::u16vec4& packedIds, glm::u16vec4& packedWeights) {
+    const int MAX = HalfEdgeMesh::MAX_INFLUENCES;
+    int order[MAX];
+    int n = 0;
+    //insertion keeps the heaviest MAX, heaviest first
+    for (int i = 0; i < count; i++) {
+        if (!(weights[i] > 0.f) || (n == MAX && weights[i] <= weights[order[n - 1]])) {
+            continue;
+        }
+        int k = n < MAX ? n++ : n - 1;
+        for (; k > 0 && weights[order[k - 1]] < weights[i]; k--) {
+            order[k] = order[k - 1];
+        }
+        order[k] = i;
+    }
+
+    packedIds = glm::u16vec4();
+    packedWeights = glm::u16vec4();
+    if (n == 0) {
+        return;
+    }
+    float total = 0.f;
+    for (int k = 0; k < n; k++) {
+        total += weights[order[k]];
+    }
+    while (n > 1 && weights[order[n - 1]] < pruneBelow * total) {
+        total -= weights[order[--n]];
+    }
+
+    //the lighter weights round down and the heaviest takes what's left, so
+    //they sum to exactly one and stay heaviest first
+    int rest = 0;
+    for (int k = 0; k < n; k++) {
+        packedIds[k] = uint16_t(ids[order[k]]);
+        if (k > 0) {
+            packedWeights[k] = uint16_t(weights[order[k]] / total * 65535.f);
+            rest += packedWeights[k];
+        }
+    }
+    packedWeights[0] = uint16_t(65535 - rest);
+}
+
+void HalfEdgeMesh::setInfluences(VertexHandle v, int count, const int* ids, const float* weights, float pruneBelow) {
+    topologyEdited = true;
+    packInfluences(count, ids, weights, pruneBelow, vertJointIds[v.idx], vertJointWeights[v.idx]);
+}
+
+bool HalfEdgeMesh::hasInfluences() const {
+    return std::any_of(vertJointWeights.begin(), vertJointWeights.end(), [](const glm::u16vec4& w) {
+        return w[0] != 0;
+    });
+}
+
+void HalfEdgeMesh::clearInfluences() {
+    std::fill(vertJointIds.begin(), vertJointIds.end(), glm::u16vec4());
+    std::fill(vertJointWeights.begin(), vertJointWeights.end(), glm::u16vec4());
+}
+
+//weights for influences at squared distances distSq, nearest first. inverse
+//distance, so a vertex sitting right on a joint or bone goes to it alone
+static void inverseDistanceWeights(int n, const float* distSq, float* weights) {
+    if (distSq[0] <= 0.f) {
+        std::fill(weights, weights + n, 0.f);
+        weights[0] = 1.f;
+        return;
+    }
+    for (int k = 0; k < n; k++) {
+        weights[k] = 1.f / std::sqrt(distSq[k]);
+    }
+}
+
+void HalfEdgeMesh::bindNearestJoints(const std::vector<glm::vec3>& jointPos, const std::vector<int>& jointIds,
+                                     int maxInfluences, float pruneBelow) {
+    if (jointPos.empty()) {
+        return;
+    }
+    TRACE_ZONE("bindNearestJoints", "core");
+    int numJoints = jointPos.size();
+    int k = glm::clamp(maxInfluences, 1, MAX_INFLUENCES);
+    //every vertex is independent, so they're bound in parallel straight
+    //into the influence arrays
+    parallel::forEach(numVertices(), [&](int i) {
+        //the k nearest by squared distance, nearest first
+        int nearest[MAX_INFLUENCES];
+        float dists[MAX_INFLUENCES];
+        int n = 0;
+        for (int j = 0; j < numJoints; j++) {
+            glm::vec3 d = vertPos[i] - jointPos[j];
+            float dist = glm::dot(d, d);
+            if (n == k && dist >= dists[n - 1]) {
+                continue;
+            }
+            int slot = n < k ? n++ : n - 1;
+            for (; slot > 0 && dists[slot - 1] > dist; slot--) {
+                nearest[slot] = nearest[slot - 1];
+                dists[slot] = dists[slot - 1];
+            }
+            nearest[slot] = jointIds[j];
+            dists[slot] = dist;
+        }
+
+        float weights[MAX_INFLUENCES];
+        inverseDistanceWeights(n, dists, weights);
+        packInfluences(n, nearest, weights, pruneBelow, vertJointIds[i], vertJointWeights[i]);
+    });
+    topologyEdited = true;
+}
+
+void HalfEdgeMesh::bindNearestBones(const std::vector<glm::vec3>& jointPos, const std::vector<int>& jointParents,
+                                    const std::vector<int>& jointIds, int maxInfluences, float pruneBelow) {
+    //each bone as a start, a direction and 1 / its squared length, so the
+    //closest point on it is one dot product and a clamp away
+    std::vector<glm::vec3> boneStart, boneDir;
+    std::vector<float> boneInvLenSq;
+    std::vector<int> boneJoint;
+    for (size_t j = 0; j < jointPos.size(); j++) {
+        int p = jointParents[j];
+        if (p < 0) {
+            continue;
+        }
+        glm::vec3 dir = jointPos[j] - jointPos[p];
+        float lenSq = glm::dot(dir, dir);
+        boneStart.push_back(jointPos[p]);
+        boneDir.push_back(dir);
+        boneInvLenSq.push_back(lenSq > 0.f ? 1.f / lenSq : 0.f);
+        boneJoint.push_back(p);
+    }
+    if (boneJoint.empty()) {
+        bindNearestJoints(jointPos, jointIds, maxInfluences, pruneBelow);
+        return;
+    }
+
+    TRACE_ZONE("bindNearestBones", "core");
+    int numBones = boneJoint.size();
+    int k = glm::clamp(maxInfluences, 1, MAX_INFLUENCES);
+    parallel::forEach(numVertices(), [&](int i) {
+        glm::vec3 pos = vertPos[i];
+        //the k nearest distinct driving joints, nearest first. sibling bones
+        //share a parent, so a joint already held just keeps its closer distance
+        int nearest[MAX_INFLUENCES];
+        float dists[MAX_INFLUENCES];
+        int n = 0;
+        for (int b = 0; b < numBones; b++) {
+            glm::vec3 rel = pos - boneStart[b];
+            float t = glm::clamp(glm::dot(rel, boneDir[b]) * boneInvLenSq[b], 0.f, 1.f);
+            glm::vec3 d = rel - t * boneDir[b];
+            float dist = glm::dot(d, d);
+            int joint = boneJoint[b];
+
+            int slot = 0;
+            while (slot < n && nearest[slot] != joint) {
+                slot++;
+            }
+            if (slot == n) {
+                if (n == k && dist >= dists[n - 1]) {
+                    continue;
+                }
+                slot = n < k ? n++ : n - 1;
+            } else if (dist >= dists[slot]) {
+                continue;
+            }
+            for (; slot > 0 && dists[slot - 1] > dist; slot--) {
+                nearest[slot] = nearest[slot - 1];
+                dists[slot] = dists[slot - 1];
+            }
+            nearest[slot] = joint;
+            dists[slot] = dist;
+        }
+
+        for (int s = 0; s < n; s++) {
+            nearest[s] = jointIds[nearest[s]];
+        }
+        float weights[MAX_INFLUENCES];
+        inverseDistanceWeights(n, dists, weights);
+        packInfluences(n, nearest, weights, pruneBelow, vertJointIds[i], vertJointWeights[i]);
+    });
+    topologyEdited = true;
+}
+
+void HalfEdgeMesh::enableStencils() {
+    controlPos = vertPos;
+    stencils = StencilTable::identity(numVertices());
+}
+
+void HalfEdgeMesh::clearStencils() {
+    controlPos.clear();
+    controlPos.shrink_to_fit();
+    stencils.clear();
+}
+
+bool HalfEdgeMesh::hasStencils() const {
+    return !controlPos.empty();
+}
+
+int HalfEdgeMesh::numControlVertices() const {
+    return controlPos.size();
+}
+
+glm::vec3 HalfEdgeMesh::getControlPos(VertexHandle v) const {
+    return controlPos[v.idx];
+}
+
+VertexHandle HalfEdgeMesh::splitEdge(HalfEdgeHandle he1) {
+    //the cage can't follow topology edits, so they work on the refined mesh
+    clearStencils();
+    HalfEdgeHandle he2 = getSym(he1);
+    VertexHandle v1 = getVertex(he1);
+    VertexHandle v2 = getVertex(he2);
+    //v3 has average pos of vert before and after he
+    VertexHandle v3 = this->addVertex((getPos(v2) + getPos(v1)) / 2.f);
+    HalfEdgeHandle he1b = this->addHE(), he2b = this->addHE();
+
+    setVertex(he1b, v1);
+    setVertex(he2b, v2);
+
+    vertHE[v1.idx] = he1b.idx;
+    vertHE[v2.idx] = he2b.idx;
+
+    setFace(he1b, getFace(he1));
+    setFace(he2b, getFace(he2));
+
+    setNext(he1b, getNext(he1));
+    setNext(he2b, getNext(he2));
+
+    setNext(he1, he1b);
+    setNext(he2, he2b);
+
+    setVertex(he1, v3);
+    setVertex(he2, v3);
+
+    vertHE[v3.idx] = he1.idx;
+
+    setSym(he1, he2b);
+    setSym(he2, he1b);
+
+    return v3;
+}
+
+void HalfEdgeMesh::triangulateFace(FaceHandle f) {
+    clearStencils();
+    int numVerts = getValence(f);
+
+    if (numVerts <= 3) {
+        return;
+    }
+
+    HalfEdgeHandle he_0 = getHE(f);
+
+    for (int i = 0; i < numVerts - 3; i++) {
+        HalfEdgeHandle he_a = this->addHE(), he_b = this->addHE();
+        HalfEdgeHandle he_1 = getNext(he_0), he_2 = getNext(he_1);
+
+        setVertex(he_a, getVertex(he_0));
+        setVertex(he_b, getVertex(he_2));
+        setSym(he_a, he_b);
+        FaceHandle f2 = this->addFace(getColor(f));
+        setFace(he_a, f2);
+        setFace(he_1, f2);
+        setFace(he_2, f2);
+        setFace(he_b, f);
+        setNext(he_b, getNext(he_2));
+        setNext(he_2, he_a);
+        setNext(he_a, he_1);
+        setNext(he_0, he_b);
+
+        he_0 = getNext(he_0);
+    }
+}
+
+void HalfEdgeMesh::catmullclarkSubdivision() {
+    const int numOldVerts = numVertices(), numOldFaces = numFaces(), numOldHes = numHes();
+    trace::Zone traceZone("catmullclarkSubdivision", "core");
+    traceZone.arg("faces", numOldFaces);
+
+    //every half-edge h becomes the quad at the corner of its face around the
+    //vertex h points to, so the refined level has exactly 4 hes per old he and
+    //one face per old he. new vertices are laid out as
+    //[old vertices | face points | edge points], so every new index is plain
+    //arithmetic on old indices and the whole level can be built in one pass
+
+    //step 0: number the edges. an he owns its edge if its sym has a higher
+    //index (or it has no sym), owners are counted per chunk and a prefix sum
+    //over the chunk counts gives each chunk its first edge index
+    std::vector<uint32_t> heEdge(numOldHes);
+    std::vector<uint32_t> hePrev(numOldHes);
+    auto ownsEdge = [this](uint32_t he) {
+        return heSym[he] == INVALID_IDX || he < heSym[he];
+    };
+    std::vector<uint32_t> chunkEdges(parallel::chunksFor(numOldHes) + 1, 0);
+    parallel::forChunks(numOldHes, [&](int chunk, int begin, int end) {
+        uint32_t owned = 0;
+        for (int he = begin; he < end; he++) {
+            owned += ownsEdge(he);
+            hePrev[heNext[he]] = he;
+        }
+        chunkEdges[chunk + 1] = owned;
+    });
+    for (int c = 1; c < (int)chunkEdges.size(); c++) {
+        chunkEdges[c] += chunkEdges[c - 1];
+    }
+    const int numEdges = chunkEdges.back();
+    parallel::forChunks(numOldHes, [&](int chunk, int begin, int end) {
+        uint32_t edge = chunkEdges[chunk];
+        for (int he = begin; he < end; he++) {
+            if (ownsEdge(he)) {
+                heEdge[he] = edge++;
+            }
+        }
+    });
+    parallel::forEach(numOldHes, [&](int he) {
+        if (!ownsEdge(he)) {
+            heEdge[he] = heEdge[heSym[he]];
+        }
+    });
+
+    const uint32_t facePointBase = numOldVerts;
+    const uint32_t edgePointBase = numOldVerts + numOldFaces;
+    const int numNewVerts = numOldVerts + numOldFaces + numEdges;
+    const int numNewHes = 4 * numOldHes;
+
+    std::vector<glm::vec3> newPos(numNewVerts);
+
+    //step 1: face points are the centroids of their faces
+    parallel::forEach(numOldFaces, [&](int f) {
+        float numVerts = 0.f;
+        glm::vec3 avgPos;
+        uint32_t loopHE = faceHE[f];
+        do {
+            numVerts++;
+            avgPos += vertPos[heVert[loopHE]];
+            loopHE = heNext[loopHE];
+        } while (loopHE != faceHE[f]);
+        newPos[facePointBase + f] = avgPos / numVerts;
+    });
+
+    //step 2: smoothed edge points
+    //e = (v1 + v2 + f1 + f2) / 4, or the plain midpoint on a boundary
+    parallel::forEach(numOldHes, [&](int he) {
+        if (!ownsEdge(he)) {
+            return;
+        }
+        uint32_t sym = heSym[he];
+        glm::vec3 v1 = vertPos[heVert[he]];
+        glm::vec3 v2 = vertPos[heVert[hePrev[he]]];
+        glm::vec3 &edgePoint = newPos[edgePointBase + heEdge[he]];
+        if (sym == INVALID_IDX) {
+            edgePoint = (v1 + v2) / 2.f;
+        } else {
+            glm::vec3 f1 = newPos[facePointBase + heFace[he]];
+            glm::vec3 f2 = newPos[facePointBase + heFace[sym]];
+            edgePoint = (v1 + v2 + f1 + f2) / 4.f;
+        }
+    });
+
+    //step 3: smooth the original vertices
+    //v' = (n-2)v/n +
+    //     sum(e)/n^2 +
+    //     sum(f)/n^2
+    //vertices on a boundary are left where they are
+    parallel::forEach(numOldVerts, [&](int v) {
+        glm::vec3 sumCentroids = glm::vec3();
+        glm::vec3 sumMidpts = glm::vec3();
+        newPos[v] = vertPos[v];
+        if (vertHE[v] == INVALID_IDX) {
+            return;
+        }
+
+        //loopHE is always an he pointing into the vertex
+        uint32_t loopHE = vertHE[v];
+        float n = 0.f;
+        do {
+            sumCentroids += newPos[facePointBase + heFace[loopHE]];
+            sumMidpts += newPos[edgePointBase + heEdge[loopHE]];
+
+            loopHE = heSym[heNext[loopHE]];
+            if (loopHE == INVALID_IDX) {
+                return;
+            }
+
+            n++;
+        } while (loopHE != vertHE[v]);
+        //smooth vertex using equation from slides
+        newPos[v] = (n - 2.f) * vertPos[v] / n +
+                    sumMidpts / (n * n) +
+                    sumCentroids / (n * n);
+    });
+
+    //step 4: build the refined topology. the quad for old he h is
+    //  4h+0: edge point of h     -> vertex of h
+    //  4h+1: vertex of h         -> edge point of next(h)
+    //  4h+2: edge point of next  -> face point
+    //  4h+3: face point          -> edge point of h
+    std::vector<uint32_t> newNext(numNewHes), newSym(numNewHes), newFace(numNewHes), newVert(numNewHes);
+    std::vector<uint32_t> newFaceHE(numOldHes);
+    std::vector<glm::vec3> newColor(numOldHes);
+    parallel::forEach(numOldHes, [&](int he) {
+        uint32_t q = 4 * he;
+        uint32_t next = heNext[he], prev = hePrev[he];
+        uint32_t sym = heSym[he], nextSym = heSym[next];
+
+        for (uint32_t k = 0; k < 4; k++) {
+            newNext[q + k] = q + (k + 1) % 4;
+            newFace[q + k] = he;
+        }
+
+        newVert[q + 0] = heVert[he];
+        newVert[q + 1] = edgePointBase + heEdge[next];
+        newVert[q + 2] = facePointBase + heFace[he];
+        newVert[q + 3] = edgePointBase + heEdge[he];
+
+        //the outer halves pair up with the neighbouring faces' quads,
+        //the spokes to the face point pair up within this face
+        newSym[q + 0] = sym == INVALID_IDX ? INVALID_IDX : 4 * hePrev[sym] + 1;
+        newSym[q + 1] = nextSym == INVALID_IDX ? INVALID_IDX : 4 * nextSym + 0;
+        newSym[q + 2] = 4 * next + 3;
+        newSym[q + 3] = 4 * prev + 2;
+
+        newFaceHE[he] = q;
+        newColor[he] = faceColor[heFace[he]];
+    });
+
+    std::vector<uint32_t> newVertHE(numNewVerts);
+    parallel::forEach(numOldVerts, [&](int v) {
+        newVertHE[v] = vertHE[v] == INVALID_IDX ? INVALID_IDX : 4 * vertHE[v];
+    });
+    parallel::forEach(numOldFaces, [&](int f) {
+        newVertHE[facePointBase + f] = 4 * faceHE[f] + 2;
+    });
+    parallel::forEach(numOldHes, [&](int he) {
+        if (ownsEdge(he)) {
+            newVertHE[edgePointBase + heEdge[he]] = 4 * he + 3;
+        }
+    });
+
+    //step 5: in stencil mode fold this level into the cage's table, built
+    //before the swap since it reads the old connectivity
+    if (hasStencils()) {
+        stencils = buildLevelStencils(heEdge, hePrev, numEdges).compose(stencils);
+    }
+
+    topologyEdited = true;
+    heNext.swap(newNext);
+    heSym.swap(newSym);
+    heFace.swap(newFace);
+    heVert.swap(newVert);
+    vertPos.swap(newPos);
+    vertHE.swap(newVertHE);
+    faceHE.swap(newFaceHE);
+    faceColor.swap(newColor);
+    //new vertices start without a normal or joint influences
+    vertNor.resize(numNewVerts);
+    vertJointIds.resize(numNewVerts);
+    vertJointWeights.resize(numNewVerts);
+}
+
+StencilTable HalfEdgeMesh::buildLevelStencils(const std::vector<uint32_t>& heEdge, const std::vector<uint32_t>& hePrev, int numEdges) const {
+    const int numOldVerts = numVertices(), numOldFaces = numFaces(), numOldHes = numHes();
+    const uint32_t facePointBase = numOldVerts;
+    const uint32_t edgePointBase = numOldVerts + numOldFaces;
+
+    //the he that owns each edge, to go from an edge point back to its edge
+    std::vector<uint32_t> edgeHE(numEdges);
+    parallel::forEach(numOldHes, [&](int he) {
+        if (heSym[he] == INVALID_IDX || (uint32_t)he < heSym[he]) {
+            edgeHE[heEdge[he]] = he;
+        }
+    });
+
+    //the same rules as steps 1-3 written out as weights on the old vertices
+    typedef std::vector<StencilTable::Entry> Row;
+    auto addFacePoint = [this](uint32_t f, float w, Row& row) {
+        int n = getValence(FaceHandle(f));
+        uint32_t loopHE = faceHE[f];
+        do {
+            row.push_back(StencilTable::Entry(heVert[loopHE], w / n));
+            loopHE = heNext[loopHE];
+        } while (loopHE != faceHE[f]);
+    };
+    auto addEdgePoint = [&](uint32_t he, float w, Row& row) {
+        uint32_t sym = heSym[he];
+        if (sym == INVALID_IDX) {
+            row.push_back(StencilTable::Entry(heVert[he], w / 2.f));
+            row.push_back(StencilTable::Entry(heVert[hePrev[he]], w / 2.f));
+        } else {
+            row.push_back(StencilTable::Entry(heVert[he], w / 4.f));
+            row.push_back(StencilTable::Entry(heVert[hePrev[he]], w / 4.f));
+            addFacePoint(heFace[he], w / 4.f, row);
+            addFacePoint(heFace[sym], w / 4.f, row);
+        }
+    };
+    auto addVertexPoint = [&](uint32_t v, Row& row) {
+        //boundary and isolated vertices stay where they are
+        std::vector<uint32_t> ring;
+        uint32_t loopHE = vertHE[v];
+        if (loopHE != INVALID_IDX) {
+            do {
+                ring.push_back(loopHE);
+                loopHE = heSym[heNext[loopHE]];
+            } while (loopHE != INVALID_IDX && loopHE != vertHE[v]);
+        }
+        if (loopHE == INVALID_IDX) {
+            row.push_back(StencilTable::Entry(v, 1.f));
+            return;
+        }
+        float n = ring.size();
+        row.push_back(StencilTable::Entry(v, (n - 2.f) / n));
+        for (uint32_t he : ring) {
+            addFacePoint(heFace[he], 1.f / (n * n), row);
+            addEdgePoint(he, 1.f / (n * n), row);
+        }
+    };
+
+    int numNewVerts = numOldVerts + numOldFaces + numEdges;
+    return StencilTable::build(numNewVerts, numOldVerts, [&](int i, Row& row) {
+        if ((uint32_t)i < facePointBase) {
+            addVertexPoint(i, row);
+        } else if ((uint32_t)i < edgePointBase) {
+            addFacePoint(i - facePointBase, 1.f, row);
+        } else {
+            addEdgePoint(edgeHE[i - edgePointBase], 1.f, row);
+        }
+    });
+}
+
+void HalfEdgeMesh::extrudeFace(FaceHandle f) {
+    clearStencils();
+    std::vector<HalfEdgeHandle> faceHes;
+    HalfEdgeHandle loopHE = getHE(f);
+
+    //loop stores the face's hes in faceHes
+    do {
+        loopHE = getNext(loopHE);
+        faceHes.push_back(loopHE);
+    } while (loopHE != getHE(f));
+
+    //calculate normal
+    HalfEdgeHandle he0 = getHE(f), he1 = getNext(he0), he2 = getNext(he1);
+    glm::vec3 normal = glm::normalize(glm::cross(getPos(getVertex(he1)) - getPos(getVertex(he0)),
+                                                 getPos(getVertex(he2)) - getPos(getVertex(he1))));
+
+    //make one new vertex for each he
+    std::vector<VertexHandle> newVerts;
+    for (int i = 0; i < (int)faceHes.size(); i++) {
+        newVerts.push_back(this->addVertex(glm::vec3()));
+    }
+
+    //vector for edges that will be in the top face
+    std::vector<HalfEdgeHandle> topEdges;
+
+    bool firstIter = true;
+    HalfEdgeHandle prevHE2, firstHE1;
+
+    //make a face for each edge in faceHes
+    for (int i = 0; i < (int)faceHes.size(); i++) {
+        HalfEdgeHandle ogHe = faceHes[i];
+        //the base vertex is where the previous he points, a boundary he has
+        //no sym to read it from. ogHe keeps whatever sym it had, so on a
+        //boundary the side face's outer edge stays a boundary
+        VertexHandle ogV1 = getVertex(faceHes[(i + faceHes.size() - 1) % faceHes.size()]);
+        VertexHandle ogV2 = getVertex(ogHe);
+        FaceHandle newFace = this->addFace(getColor(f));
+        VertexHandle v1 = newVerts[i], v2 = newVerts[(i + 1) % newVerts.size()];
+
+        //he1's sym will have to be set to the prev he2
+        //he1 points into ogHe base vert
+        //he2 points out of ogHe vert
+        //he3 points into base of he1(top edge
+        HalfEdgeHandle he1 = this->addHE(), he2 = this->addHE(), he3 = this->addHE();
+
+        setVertex(he1, ogV1);
+        setVertex(he2, v2);
+        setVertex(he3, v1);
+
+        setPos(v1, getPos(ogV1) + normal * 0.5f);
+        setPos(v2, getPos(ogV2) + normal * 0.5f);
+
+        vertHE[v1.idx] = he3.idx;
+        vertHE[v2.idx] = he2.idx;
+
+        //set nexts of edges
+        setNext(ogHe, he2);
+        setNext(he2, he3);
+        setNext(he3, he1);
+        setNext(he1, ogHe);
+
+        //set face pointers
+        setFace(ogHe, newFace);
+        setFace(he1, newFace);
+        setFace(he2, newFace);
+        setFace(he3, newFace);
+
+        //he3 will need to be kept track of for making the top face
+        topEdges.push_back(he3);
+
+        if (firstIter) {
+            firstIter = false;
+            firstHE1 = he1;
+        } else {
+            setSym(prevHE2, he1);
+        }
+
+        prevHE2 = he2;
+    }
+
+    setSym(firstHE1, prevHE2);
+
+    //handle top face
+    std::vector<HalfEdgeHandle> newTopEdges;
+    for (int i = 0; i < (int)topEdges.size(); i++) {
+        HalfEdgeHandle newTopEdge = this->addHE();
+        setFace(newTopEdge, f);
+        setSym(newTopEdge, topEdges[i]);
+        setVertex(newTopEdge, getVertex(getNext(getNext(getNext(topEdges[i])))));
+        newTopEdges.push_back(newTopEdge);
+    }
+
+    //set nexts for top face
+    for (int i = 0; i < (int)newTopEdges.size(); i++) {
+        setNext(newTopEdges[i], newTopEdges[(i + 1) % newTopEdges.size()]);
+    }
+}
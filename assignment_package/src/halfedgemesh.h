@@ -0,0 +1,183 @@
+#ifndef HALFEDGEMESH_H
+#define HALFEDGEMESH_H
+
+#include <la.h>
+#include <glm/gtc/type_precision.hpp>
+#include <component.h>
+#include <stenciltable.h>
+#include <vector>
+
+//gl-free half-edge mesh. every element is a row in a set of flat arrays
+//(struct of arrays) and elements refer to each other by 32-bit index
+//instead of by pointer, so traversals stay inside a few contiguous buffers
+class HalfEdgeMesh {
+protected:
+    //per half-edge connectivity
+    std::vector<uint32_t> heNext;
+    std::vector<uint32_t> heSym;
+    std::vector<uint32_t> heFace;
+    std::vector<uint32_t> heVert; //vertex the half-edge points to
+
+    //per vertex data
+    std::vector<glm::vec3> vertPos;
+    std::vector<glm::vec3> vertNor;
+    std::vector<uint32_t> vertHE; //a half-edge pointing to the vertex
+
+    //per face data
+    std::vector<uint32_t> faceHE;
+    std::vector<glm::vec3> faceColor;
+
+    //added for hw7 -- the joints that influence each vertex, packed the way
+    //the skinning shader reads them: up to MAX_INFLUENCES joint indices as
+    //uint16s and their weights as unorm16 summing to 65535, heaviest first.
+    //unused slots have weight 0, an unbound vertex has all four at 0
+    std::vector<glm::u16vec4> vertJointIds;
+    std::vector<glm::u16vec4> vertJointWeights;
+
+    //stencil mode. the control cage positions and the table that maps them
+    //onto the current vertices, so moving a cage vertex after subdividing
+    //only re-runs the weighted sums instead of subdividing again
+    std::vector<glm::vec3> controlPos;
+    StencilTable stencils;
+
+    //edit log for anything mirroring the mesh elsewhere (i.e. the vbos).
+    //position and color edits list the elements they touched, anything that
+    //changes connectivity just raises topologyEdited
+    bool topologyEdited;
+    std::vector<uint32_t> editedVerts;
+    std::vector<uint32_t> editedFaces;
+
+    //what twin matching found when the mesh was built from faces
+    int boundaryEdges;
+    int nonManifoldEdges;
+
+    void build(const std::vector<glm::vec3>& vertices, const std::vector<glm::vec3>& normals,
+               const std::vector<uint32_t>& faceOffsets, const std::vector<uint32_t>& faceIndices);
+    //links syms for hes built from faceIndices by sorting them on their edge
+    void matchTwins(const std::vector<uint32_t>& faceIndices);
+
+    void logVertex(uint32_t v);
+    void logFace(uint32_t f);
+    void clearEdits();
+
+    //saves and restores the arrays above directly
+    friend class MeshCache;
+
+public:
+    //joints per vertex. four fill one integer and one float vec4 attribute
+    static constexpr int MAX_INFLUENCES = 4;
+    //binding drops influences lighter than this share of the vertex and
+    //renormalizes the rest
+    static constexpr float PRUNE_WEIGHT = 0.02f;
+
+    HalfEdgeMesh();
+    HalfEdgeMesh(const std::vector<glm::vec3>& vertices, const std::vector<glm::vec3>& normals, const std::vector<std::vector<int>>& faces);
+    //faces stored flat, face f is faceIndices[faceOffsets[f]] up to faceIndices[faceOffsets[f + 1]]
+    HalfEdgeMesh(const std::vector<glm::vec3>& vertices, const std::vector<glm::vec3>& normals,
+                 const std::vector<uint32_t>& faceOffsets, const std::vector<uint32_t>& faceIndices);
+
+    //element creation, each returns the handle of the new element
+    VertexHandle addVertex(glm::vec3 pos);
+    HalfEdgeHandle addHE();
+    FaceHandle addFace(glm::vec3 color);
+
+    int numVertices() const;
+    int numHes() const;
+    int numFaces() const;
+    bool hasVertices() const;
+    //the faces flat, in the layout the constructor takes. each face starts
+    //at the vertex its he points to
+    void getFaces(std::vector<uint32_t>& faceOffsets, std::vector<uint32_t>& faceIndices) const;
+    //edges with one face, and edges whose faces couldn't be paired up
+    //(three or more faces, or two faces wound the same way). counted by the
+    //constructor, and not updated by later edits
+    int numBoundaryEdges() const;
+    int numNonManifoldEdges() const;
+    int calcTotalIndices() const;
+    //true if something changed since the edit log was last cleared
+    bool hasEdits() const;
+    //true if the connectivity changed since then
+    bool hasTopologyEdits() const;
+
+    //half-edge accessors
+    HalfEdgeHandle getNext(HalfEdgeHandle he) const;
+    HalfEdgeHandle getSym(HalfEdgeHandle he) const;
+    FaceHandle getFace(HalfEdgeHandle he) const;
+    VertexHandle getVertex(HalfEdgeHandle he) const;
+    //walks the face loop to find the half-edge whose next is he
+    HalfEdgeHandle getPrev(HalfEdgeHandle he) const;
+
+    void setNext(HalfEdgeHandle he, HalfEdgeHandle next);
+    //links both half-edges to each other
+    void setSym(HalfEdgeHandle he, HalfEdgeHandle sym);
+    //sets the he's face and makes the face point back at the he
+    void setFace(HalfEdgeHandle he, FaceHandle f);
+    void setVertex(HalfEdgeHandle he, VertexHandle v);
+
+    //vertex accessors
+    glm::vec3 getPos(VertexHandle v) const;
+    glm::vec3 getNor(VertexHandle v) const;
+    HalfEdgeHandle getHE(VertexHandle v) const;
+    void setPos(VertexHandle v, glm::vec3 pos);
+    void setX(VertexHandle v, float x);
+    void setY(VertexHandle v, float y);
+    void setZ(VertexHandle v, float z);
+
+    //face accessors
+    HalfEdgeHandle getHE(FaceHandle f) const;
+    glm::vec3 getColor(FaceHandle f) const;
+    int getValence(FaceHandle f) const;
+    void setColor(FaceHandle f, glm::vec3 color);
+    void setR(FaceHandle f, float r);
+    void setG(FaceHandle f, float g);
+    void setB(FaceHandle f, float b);
+
+    //the current vertices become the control cage, later subdivisions keep
+    //them editable through the stencil table
+    void enableStencils();
+    //bakes the current positions and drops the cage
+    void clearStencils();
+    bool hasStencils() const;
+    //cage vertices keep their indices at every level, so these are
+    //vertices [0, numControlVertices())
+    int numControlVertices() const;
+    glm::vec3 getControlPos(VertexHandle v) const;
+
+    //joint influences, added for hw7. unused slots read as joint 0 weight 0
+    glm::ivec4 getJointIds(VertexHandle v) const;
+    glm::vec4 getJointWeights(VertexHandle v) const;
+    int numInfluences(VertexHandle v) const;
+    //packs count (id, weight) pairs into v's slots: the heaviest
+    //MAX_INFLUENCES are kept, any under pruneBelow of the total are
+    //dropped (the heaviest always stays) and the rest renormalized.
+    //ids have to fit in 16 bits
+    void setInfluences(VertexHandle v, int count, const int* ids, const float* weights, float pruneBelow = 0.f);
+    //whether any vertex has been bound to a joint
+    bool hasInfluences() const;
+    //unbinds every vertex
+    void clearInfluences();
+    //gives every vertex the maxInfluences joints closest to it, weighted by
+    //inverse distance. joint i sits at jointPos[i] and is stored as jointIds[i]
+    void bindNearestJoints(const std::vector<glm::vec3>& jointPos, const std::vector<int>& jointIds,
+                           int maxInfluences = MAX_INFLUENCES, float pruneBelow = PRUNE_WEIGHT);
+    //same, but measured to the bones instead of the joints. joint i with a
+    //parent p (jointParents[i] >= 0) makes a bone from jointPos[p] to
+    //jointPos[i] that moves with p, so each vertex gets the joints driving
+    //its nearest bones. a skeleton with no bones falls back to bindNearestJoints
+    void bindNearestBones(const std::vector<glm::vec3>& jointPos, const std::vector<int>& jointParents,
+                          const std::vector<int>& jointIds, int maxInfluences = MAX_INFLUENCES, float pruneBelow = PRUNE_WEIGHT);
+
+    VertexHandle splitEdge(HalfEdgeHandle he1);
+    void triangulateFace(FaceHandle f);
+    //builds the next subdivision level into fresh arrays with data-parallel loops
+    void catmullclarkSubdivision();
+    void extrudeFace(FaceHandle toExtrude);
+
+private:
+    //moves v, going through the cage when v is a control vertex
+    void movePos(VertexHandle v, glm::vec3 pos);
+    //the stencil for one level of subdivision in terms of the level before it
+    StencilTable buildLevelStencils(const std::vector<uint32_t>& heEdge, const std::vector<uint32_t>& hePrev, int numEdges) const;
+};
+
+#endif // HALFEDGEMESH_H
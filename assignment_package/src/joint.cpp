@@ -1,30 +1,13 @@
 #include "joint.h"
+#include <trace.h>
+#include <algorithm>
 
 #define PI 3.1415926535f
 
-Joint::Joint() :
-    Drawable(nullptr), name(""), parent(nullptr), pos_relative(glm::vec3()), rot(glm::quat()), bindMat(glm::mat4()), selected(false), id(topId + 1)
+Joint::Joint(SkeletonPose* pose, int id, QString name) :
+    name(name), pose(pose), selected(false), id(id)
 {
-    topId++;
-}
-
-Joint::Joint(OpenGLContext *context) :
-    Drawable(context), name(""), parent(nullptr), pos_relative(glm::vec3()), rot(glm::quat()), bindMat(glm::mat4()), selected(false), id(topId + 1)
-{
-    topId++;
-}
-
-
-Joint::Joint(OpenGLContext* context, glm::vec3 pos) :
-    Drawable(context), name(""), parent(nullptr), pos_relative(pos), rot(glm::quat()), bindMat(glm::mat4()), selected(false), id(topId + 1)
-{
-    topId++;
-}
-
-Joint::Joint(OpenGLContext *context, QString name, glm::vec3 pos, glm::quat rot) :
-    Drawable(context), name(name), parent(nullptr), pos_relative(pos), rot(rot), selected(false), id(topId + 1)
-{
-    topId++;
+    setText(0, QString::number(id) + ": " + name);
 }
 
 Joint::~Joint() {}
@@ -34,30 +17,18 @@ void Joint::addChild(uPtr<Joint> newChild) {
     this->children.push_back(std::move(newChild));
 }
 
-void Joint::setParent(Joint* p) {
-    this->parent = p;
-}
-
-void Joint::updateBindMat() {
-    this->bindMat = glm::inverse(this->getOverallTransformation());
-    for (auto& child : children) {
-        child->updateBindMat();
-    }
-}
-
-glm::mat4 Joint::getBind() {
-    return this->bindMat;
+glm::mat4 Joint::getBind() const {
+    return pose->getBindTransforms()[id];
 }
 
 glm::mat4 Joint::getLocalTransformation() const {
-    return glm::translate(glm::mat4(), pos_relative) * glm::toMat4(rot);
+    pose->update();
+    return pose->getLocal(id);
 }
 
 glm::mat4 Joint::getOverallTransformation() const {
-    if (!parent) {
-        return this->getLocalTransformation();
-    }
-    return parent->getOverallTransformation() * this->getLocalTransformation();
+    pose->update();
+    return pose->getWorld(id);
 }
 
 QString Joint::getName() const {
@@ -80,133 +51,128 @@ void Joint::unselect() {
     this->selected = false;
 }
 
-void Joint::create() {
-    //draw sphere
-    std::vector<glm::vec4> col;
-    std::vector<glm::vec4> pos;
-    std::vector<GLuint> idx;
-
-    //y ring
-    glm::vec4 rotAbtY = glm::vec4(0.5, 0, 0, 1);
-    glm::mat4 rotateMat = glm::rotate(glm::mat4(), PI / 6.f, glm::vec3(0, 1, 0));
-
-    glm::vec4 drawColor = selected ? glm::vec4(0.8, 0, 0.8, 1) : glm::vec4(1, 1, 1, 1);
-
-    for (int i = 0; i < 12; i++) {
-        pos.push_back(rotAbtY);
-        col.push_back(drawColor);
-        rotAbtY = rotateMat * rotAbtY;
-    }
-
-    //x ring
-    glm::vec4 rotAbtX = glm::vec4(0, 0, 0.5, 1);
-    rotateMat = glm::rotate(glm::mat4(), PI / 6.f, glm::vec3(1, 0, 0));
-
-    for (int i = 0; i < 12; i++) {
-        pos.push_back(rotAbtX);
-        col.push_back(drawColor);
-        rotAbtX = rotateMat * rotAbtX;
-    }
-
-    //z ring
-    glm::vec4 rotAbtZ = glm::vec4(0, 0.5, 0, 1);
-    rotateMat = glm::rotate(glm::mat4(), PI / 6.f, glm::vec3(0, 0, 1));
-
-    for (int i = 0; i < 12; i++) {
-        pos.push_back(rotAbtZ);
-        col.push_back(drawColor);
-        rotAbtZ = rotateMat * rotAbtZ;
-    }
-
-    for (int i = 0; i < 11; i++) {
-        idx.push_back(i);
-        idx.push_back(i + 1);
-    }
-    idx.push_back(11);
-    idx.push_back(0);
-
-    for (int i = 12; i < 23; i++) {
-        idx.push_back(i);
-        idx.push_back(i + 1);
-    }
-    idx.push_back(23);
-    idx.push_back(12);
-
-    for (int i = 24; i < 35; i++) {
-        idx.push_back(i);
-        idx.push_back(i + 1);
-    }
-    idx.push_back(35);
-    idx.push_back(24);
-
-    for (int i = 0; i < (int) pos.size(); i++) {
-        pos[i] = this->getOverallTransformation() * pos[i];
-    }
-
-    int selfIdx = pos.size();
-    if (parent != nullptr) {
-        pos.push_back(parent->getOverallTransformation() * glm::vec4(0, 0, 0, 1));
-        pos.push_back(this->getOverallTransformation() * glm::vec4(0, 0, 0, 1));
-        col.push_back(glm::vec4(1, 0, 1, 1));
-        col.push_back(glm::vec4(1, 1, 0, 1));
-        idx.push_back(selfIdx);
-        idx.push_back(selfIdx + 1);
-    }
-
-    count = idx.size();
-
-    generateIdx();
-    mp_context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufIdx);
-    mp_context->glBufferData(GL_ELEMENT_ARRAY_BUFFER, idx.size() * sizeof(GLuint), idx.data(), GL_STATIC_DRAW);
-
-    generatePos();
-    mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufPos);
-    mp_context->glBufferData(GL_ARRAY_BUFFER, pos.size() * sizeof(glm::vec4), pos.data(), GL_STATIC_DRAW);
-
-    generateCol();
-    mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufCol);
-    mp_context->glBufferData(GL_ARRAY_BUFFER, col.size() * sizeof(glm::vec4), col.data(), GL_STATIC_DRAW);
-
-}
-
-GLenum Joint::drawMode() {
-    return GL_LINES;
+bool Joint::isSelected() const {
+    return selected;
 }
 
 void Joint::posXRot() {
-    this->rot = glm::angleAxis(glm::radians(5.f), glm::vec3(1, 0, 0)) * this->rot;
+    pose->setRotation(id, glm::angleAxis(glm::radians(5.f), glm::vec3(1, 0, 0)) * pose->getRotation(id));
 }
 
 void Joint::posYRot() {
-    this->rot = glm::angleAxis(glm::radians(5.f), glm::vec3(0, 1, 0)) * this->rot;
+    pose->setRotation(id, glm::angleAxis(glm::radians(5.f), glm::vec3(0, 1, 0)) * pose->getRotation(id));
 }
 
 void Joint::posZRot() {
-    this->rot = glm::angleAxis(glm::radians(5.f), glm::vec3(0, 0, 1)) * this->rot;
+    pose->setRotation(id, glm::angleAxis(glm::radians(5.f), glm::vec3(0, 0, 1)) * pose->getRotation(id));
 }
 
 void Joint::negXRot() {
-    this->rot = glm::angleAxis(glm::radians(-5.f), glm::vec3(1, 0, 0)) * this->rot;
+    pose->setRotation(id, glm::angleAxis(glm::radians(-5.f), glm::vec3(1, 0, 0)) * pose->getRotation(id));
 }
 
 void Joint::negYRot() {
-    this->rot = glm::angleAxis(glm::radians(-5.f), glm::vec3(0, 1, 0)) * this->rot;
+    pose->setRotation(id, glm::angleAxis(glm::radians(-5.f), glm::vec3(0, 1, 0)) * pose->getRotation(id));
 }
 
 void Joint::negZRot() {
-    this->rot = glm::angleAxis(glm::radians(-5.f), glm::vec3(0, 0, 1)) * this->rot;
+    pose->setRotation(id, glm::angleAxis(glm::radians(-5.f), glm::vec3(0, 0, 1)) * pose->getRotation(id));
 }
 
 void Joint::setX(float x) {
-    this->pos_relative.x = x;
+    glm::vec3 pos = pose->getPosition(id);
+    pos.x = x;
+    pose->setPosition(id, pos);
 }
 
 void Joint::setY(float y) {
-    this->pos_relative.y = y;
+    glm::vec3 pos = pose->getPosition(id);
+    pos.y = y;
+    pose->setPosition(id, pos);
 }
 
 void Joint::setZ(float z) {
-    this->pos_relative.z = z;
+    glm::vec3 pos = pose->getPosition(id);
+    pos.z = z;
+    pose->setPosition(id, pos);
+}
+
+JointGizmo::JointGizmo(OpenGLContext* context) : Drawable(context) {}
+
+void JointGizmo::create() {
+    std::vector<glm::vec4> pos;
+    std::vector<GLuint> idx;
+
+    //a ring of 12 around each axis, radius 0.5
+    glm::vec4 starts[3] = {glm::vec4(0.5, 0, 0, 1), glm::vec4(0, 0, 0.5, 1), glm::vec4(0, 0.5, 0, 1)};
+    glm::vec3 axes[3] = {glm::vec3(0, 1, 0), glm::vec3(1, 0, 0), glm::vec3(0, 0, 1)};
+    for (int r = 0; r < 3; r++) {
+        glm::mat4 rotateMat = glm::rotate(glm::mat4(), PI / 6.f, axes[r]);
+        glm::vec4 p = starts[r];
+        for (int i = 0; i < 12; i++) {
+            idx.push_back(pos.size());
+            idx.push_back(12 * r + (i + 1) % 12);
+            pos.push_back(p);
+            p = rotateMat * p;
+        }
+    }
+
+    count = idx.size();
+
+    upload(bufIdx, idx);
+    upload(bufPos, pos);
+}
+
+GLenum JointGizmo::drawMode() {
+    return GL_LINES;
+}
+
+BoneLines::BoneLines(OpenGLContext* context) : Drawable(context), indexed(0), pos(), col() {}
+
+void BoneLines::create() {
+    //the buffers come from the pool with the first update
+    count = 0;
+    indexed = 0;
 }
 
-int Joint::topId = -1;
+void BoneLines::update(const SkeletonPose& pose) {
+    trace::Zone traceZone("BoneLines::update", "joint");
+    traceZone.arg("joints", pose.numJoints());
+    pos.clear();
+    col.clear();
+    for (int j = 0; j < pose.numJoints(); j++) {
+        int parent = pose.getParent(j);
+        if (parent >= 0) {
+            pos.push_back(glm::vec4(pose.getWorldPosition(parent), 1));
+            pos.push_back(glm::vec4(pose.getWorldPosition(j), 1));
+            col.push_back(glm::vec4(1, 0, 1, 1));
+            col.push_back(glm::vec4(1, 1, 0, 1));
+        }
+    }
+    count = pos.size();
+    if (pos.empty()) {
+        return;
+    }
+
+    //the indices are just 0, 1, 2... so they only change when there are
+    //more bones than ever before, the rest of the time the old ones cover
+    //the new count
+    if (indexed < count) {
+        while (indexed < count) {
+            indexed = std::max(64, indexed * 2);
+        }
+        std::vector<GLuint> idx(indexed);
+        for (int i = 0; i < indexed; i++) {
+            idx[i] = i;
+        }
+        upload(bufIdx, idx);
+    }
+
+    //same buffers every frame, orphaned and refilled
+    upload(bufPos, pos, GL_STREAM_DRAW);
+    upload(bufCol, col, GL_STREAM_DRAW);
+}
+
+GLenum BoneLines::drawMode() {
+    return GL_LINES;
+}
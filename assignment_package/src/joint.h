@@ -5,32 +5,28 @@
 #include "drawable.h"
 #include "smartpointerhelp.h"
 #include "la.h"
+#include <skeleton.h>
 #include <QTreeWidgetItem>
 #include <cmath>
 #include <iostream>
 
-class Joint : public Drawable, public QTreeWidgetItem {
+//the tree widget row for joint id of a SkeletonPose. the transforms
+//themselves live in the pose's flat arrays, a joint only reads and edits
+//its own entries. drawing the skeleton is JointGizmo and BoneLines' job
+class Joint : public QTreeWidgetItem {
 private:
     QString name;
-    Joint* parent;
+    SkeletonPose* pose;
     std::vector<uPtr<Joint>> children;
-    glm::vec3 pos_relative;
-    glm::quat rot;
-    glm::mat4 bindMat;
     bool selected;
     int id;
 public:
-    Joint();
-    Joint(OpenGLContext *context);
-    Joint(OpenGLContext *context, glm::vec3 pos);
-    Joint(OpenGLContext *context, QString name, glm::vec3 pos, glm::quat rot);
+    Joint(SkeletonPose* pose, int id, QString name);
     ~Joint();
 
     void addChild(uPtr<Joint> newChild);
-    void setParent(Joint* p);
 
-    void updateBindMat();
-    glm::mat4 getBind();
+    glm::mat4 getBind() const;
 
     glm::mat4 getLocalTransformation() const;
     glm::mat4 getOverallTransformation() const;
@@ -40,12 +36,10 @@ public:
 
     void select();
     void unselect();
+    bool isSelected() const;
 
     std::vector<std::unique_ptr<Joint>>& getChildren();
 
-    void create() override;
-    GLenum drawMode() override;
-
     void posXRot();
     void posYRot();
     void posZRot();
@@ -57,7 +51,36 @@ public:
     void setY(float y);
     void setZ(float z);
 
-    static int topId;
+};
+
+//the ring sphere drawn at every joint, built once around the origin. a
+//skeleton's worth of them is one instanced draw with the joint shader,
+//which places instance i with joint i's world matrix
+class JointGizmo : public Drawable {
+public:
+    JointGizmo(OpenGLContext* context);
+
+    void create() override;
+    GLenum drawMode() override;
+};
+
+//a line from every joint's parent to it, for a whole skeleton. update()
+//streams the pose into the same buffers every frame, so the bones are one
+//draw a frame however many joints there are
+class BoneLines : public Drawable {
+public:
+    BoneLines(OpenGLContext* context);
+
+    void create() override;
+    //rewrites the lines for pose, which has to be up to date
+    void update(const SkeletonPose& pose);
+    GLenum drawMode() override;
+
+private:
+    //vertices bufIdx has indices for, grows by doubling and never shrinks
+    int indexed;
+    std::vector<glm::vec4> pos;
+    std::vector<glm::vec4> col;
 };
 
 #endif // JOINT_H
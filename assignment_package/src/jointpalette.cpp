@@ -0,0 +1,98 @@
+#include "jointpalette.h"
+#include <trace.h>
+#include <glm/gtc/quaternion.hpp>
+
+JointPalette::JointPalette(OpenGLContext* context)
+    : mp_context(context), buf(), tex(0), texBuf(0), format(MATRICES), texels()
+{}
+
+void JointPalette::create() {
+    //the buffer comes from the pool with the first upload
+    mp_context->glGenTextures(1, &tex);
+}
+
+void JointPalette::destroy() {
+    mp_context->glDeleteTextures(1, &tex);
+    buf.reset();
+    tex = texBuf = 0;
+}
+
+void JointPalette::clear(Format format) {
+    this->format = format;
+    texels.clear();
+}
+
+//the rotation q and translation t of a rigid m as the dual quaternion
+//q + e * (t * q) / 2
+static void toDualQuaternion(const glm::mat4& m, glm::vec4& real, glm::vec4& dual) {
+    glm::quat q = glm::normalize(glm::quat_cast(glm::mat3(m)));
+    glm::quat d = glm::quat(0.f, glm::vec3(m[3])) * q * 0.5f;
+    real = glm::vec4(q.x, q.y, q.z, q.w);
+    dual = glm::vec4(d.x, d.y, d.z, d.w);
+}
+
+void JointPalette::push(const glm::mat4& skin) {
+    if (format == DUAL_QUATERNIONS) {
+        glm::vec4 real, dual;
+        toDualQuaternion(skin, real, dual);
+        texels.push_back(real);
+        texels.push_back(dual);
+    } else {
+        texels.insert(texels.end(), &skin[0], &skin[0] + 4);
+    }
+}
+
+int JointPalette::add(const std::vector<glm::mat4>& worlds, const std::vector<glm::mat4>& binds) {
+    int offset = numJoints();
+    //one product per joint here instead of one per influence per vertex
+    //in the shader
+    for (size_t j = 0; j < worlds.size(); j++) {
+        push(worlds[j] * binds[j]);
+    }
+    return offset;
+}
+
+int JointPalette::addSkinTransforms(const std::vector<glm::mat4>& skins) {
+    int offset = numJoints();
+    texels.reserve(texels.size() + skins.size() * texelsPerJoint());
+    for (const glm::mat4& skin : skins) {
+        push(skin);
+    }
+    return offset;
+}
+
+int JointPalette::numJoints() const {
+    return int(texels.size()) / texelsPerJoint();
+}
+
+int JointPalette::texelsPerJoint() const {
+    return format == DUAL_QUATERNIONS ? 2 : 4;
+}
+
+void JointPalette::upload() {
+    if (texels.empty()) {
+        return;
+    }
+    trace::Zone traceZone("JointPalette::upload", "skin");
+    traceZone.arg("joints", numJoints());
+    //the same buffer every frame, orphaned so the driver hands back fresh
+    //memory instead of waiting on draws still reading last frame's. it only
+    //changes when the palette outgrows its size class
+    mp_context->getBufferPool().upload(buf, texels.data(), texels.size() * sizeof(glm::vec4), GL_STREAM_DRAW);
+    if (buf.id() != texBuf) {
+        texBuf = buf.id();
+        mp_context->glBindTexture(GL_TEXTURE_BUFFER, tex);
+        mp_context->glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, texBuf);
+        mp_context->glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+}
+
+GLsizeiptr JointPalette::gpuBytes() const {
+    return buf.capacity();
+}
+
+void JointPalette::bind(int unit) {
+    mp_context->glActiveTexture(GL_TEXTURE0 + unit);
+    mp_context->glBindTexture(GL_TEXTURE_BUFFER, tex);
+    mp_context->glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <openglcontext.h>
+#include <la.h>
+#include <vector>
+
+//every skeleton's skinning matrices for a frame, in one texture buffer.
+//each skeleton added gets a joint offset, joint j of it is at offset + j,
+//and the whole frame goes up in one orphaned upload, so there's no joint
+//limit and any number of skinned meshes share it. joints are premultiplied
+//to world * bind on the way in, so the skinning shader reads one transform
+//per influence, joint i starting at texel texelsPerJoint() * i
+class JointPalette {
+public:
+    //how each joint's world * bind is packed
+    enum Format {
+        MATRICES,        //4 texels, the columns
+        DUAL_QUATERNIONS //2 texels, the real then the dual part as (x, y, z, w).
+                         //only rigid transforms survive, which joints are
+    };
+
+    JointPalette(OpenGLContext* context);
+
+    void create();
+    void destroy();
+
+    //starts a new frame's worth of matrices, packed as format
+    void clear(Format format = MATRICES);
+    //appends one skeleton's joints and returns their offset. binds are the
+    //inverse bind matrices, see SkeletonPose::getBindTransforms
+    int add(const std::vector<glm::mat4>& worlds, const std::vector<glm::mat4>& binds);
+    //same, for joints already premultiplied to world * bind (e.g. a Crowd's)
+    int addSkinTransforms(const std::vector<glm::mat4>& skins);
+    int numJoints() const;
+    int texelsPerJoint() const;
+
+    //sends everything added since clear() to the buffer
+    void upload();
+    //bytes of buffer the palette holds
+    GLsizeiptr gpuBytes() const;
+    //binds the palette's texture to texture unit `unit`
+    void bind(int unit);
+
+private:
+    void push(const glm::mat4& skin);
+
+    OpenGLContext* mp_context;
+    GLBuffer buf;
+    GLuint tex;
+    GLuint texBuf; //the buffer tex was last pointed at, buf changes when it grows
+    Format format;
+    std::vector<glm::vec4> texels;
+};
@@ -6,47 +6,56 @@
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
-    ui(new Ui::MainWindow)
+    ui(new Ui::MainWindow),
+    vertsModel(new ElementListModel("Vertex - ", this)),
+    halfEdgesModel(new ElementListModel("HalfEdge - ", this)),
+    facesModel(new ElementListModel("Face - ", this))
 {
     ui->setupUi(this);
     ui->mygl->setFocus();
 
+    ui->vertsListView->setModel(vertsModel);
+    ui->halfEdgesListView->setModel(halfEdgesModel);
+    ui->facesListView->setModel(facesModel);
+
     //makin a load OBJ button
     connect(ui->loadOBJButton, SIGNAL(clicked()),
             ui->mygl, SLOT(slot_loadOBJ()));
 
-    connect(ui->mygl,
-            // Signal name
-            SIGNAL(sig_sendHeItems(std::vector<QListWidgetItem*>&)),
-            // Widget with the slot that receives the signal
-            this,
-            // Slot name
-            SLOT(slot_addHeItems(std::vector<QListWidgetItem*>&)));
+    connect(ui->actionSave_Mesh, SIGNAL(triggered()),
+            ui->mygl, SLOT(slot_saveMesh()));
 
-    connect(ui->mygl,
-            // Signal name
-            SIGNAL(sig_sendVertexItems(std::vector<QListWidgetItem*>&)),
-            // Widget with the slot that receives the signal
-            this,
-            // Slot name
-            SLOT(slot_addVertexItems(std::vector<QListWidgetItem*>&)));
+    connect(ui->actionFrame_Times, SIGNAL(toggled(bool)),
+            ui->mygl, SLOT(slot_setShowFrameTimes(bool)));
+
+    connect(ui->actionLoad_Clip, SIGNAL(triggered()),
+            ui->mygl, SLOT(slot_loadClip()));
+
+    connect(ui->actionPlay_Clip, SIGNAL(toggled(bool)),
+            ui->mygl, SLOT(slot_setPlayClip(bool)));
+
+    connect(ui->actionCrowd, SIGNAL(toggled(bool)),
+            ui->mygl, SLOT(slot_setCrowd(bool)));
+
+    connect(ui->actionRecord_Trace, SIGNAL(toggled(bool)),
+            ui->mygl, SLOT(slot_setRecordTrace(bool)));
 
     connect(ui->mygl,
             // Signal name
-            SIGNAL(sig_sendFaceItems(std::vector<QListWidgetItem*>&)),
+            SIGNAL(sig_sendElementCounts(int,int,int,bool)),
             // Widget with the slot that receives the signal
             this,
             // Slot name
-            SLOT(slot_addFaceItems(std::vector<QListWidgetItem*>&)));
+            SLOT(slot_setElementCounts(int,int,int,bool)));
 
-    connect(ui->vertsListWidget, SIGNAL(itemClicked(QListWidgetItem*)),
-            ui->mygl, SLOT(slot_setSelectedVertex(QListWidgetItem*)));
+    connect(ui->vertsListView, SIGNAL(clicked(QModelIndex)),
+            ui->mygl, SLOT(slot_setSelectedVertex(QModelIndex)));
 
-    connect(ui->halfEdgesListWidget, SIGNAL(itemClicked(QListWidgetItem*)),
-            ui->mygl, SLOT(slot_setSelectedHE(QListWidgetItem*)));
+    connect(ui->halfEdgesListView, SIGNAL(clicked(QModelIndex)),
+            ui->mygl, SLOT(slot_setSelectedHE(QModelIndex)));
 
-    connect(ui->facesListWidget, SIGNAL(itemClicked(QListWidgetItem*)),
-            ui->mygl, SLOT(slot_setSelectedFace(QListWidgetItem*)));
+    connect(ui->facesListView, SIGNAL(clicked(QModelIndex)),
+            ui->mygl, SLOT(slot_setSelectedFace(QModelIndex)));
 
     connect(ui->splitEdgeButton, SIGNAL(clicked()),
             ui->mygl, SLOT(slot_splitEdge()));
@@ -78,12 +87,36 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->extrudeButton, SIGNAL(clicked()),
             ui->mygl, SLOT(slot_extrude()));
 
+    connect(ui->editCageCheckBox, SIGNAL(toggled(bool)),
+            ui->mygl, SLOT(slot_setEditCage(bool)));
+
+    connect(ui->sharedVertsCheckBox, SIGNAL(toggled(bool)),
+            ui->mygl, SLOT(slot_setSharedVertices(bool)));
+
+    connect(ui->levelSpinBox, SIGNAL(valueChanged(int)),
+            ui->mygl, SLOT(slot_setLevel(int)));
+
+    connect(ui->mygl, SIGNAL(sig_sendLevels(int,int)),
+            this, SLOT(slot_setLevels(int,int)));
+
+    connect(ui->mygl, SIGNAL(sig_sendEditStats(int,int)),
+            this, SLOT(slot_setEditStats(int,int)));
+
     connect(ui->loadJSONButton, SIGNAL(clicked()),
             ui->mygl, SLOT(slot_loadJSON()));
 
     connect(ui->skinMeshButton, SIGNAL(clicked()),
             ui->mygl, SLOT(slot_skinMesh()));
 
+    connect(ui->bindBonesCheckBox, SIGNAL(toggled(bool)),
+            ui->mygl, SLOT(slot_setBindToBones(bool)));
+
+    connect(ui->influencesSpinBox, SIGNAL(valueChanged(int)),
+            ui->mygl, SLOT(slot_setMaxInfluences(int)));
+
+    connect(ui->dualQuatCheckBox, SIGNAL(toggled(bool)),
+            ui->mygl, SLOT(slot_setDualQuat(bool)));
+
     connect(ui->mygl,
             SIGNAL(sig_sendRootNode(QTreeWidgetItem*)),
             this,
@@ -140,34 +173,29 @@ void MainWindow::on_actionCamera_Controls_triggered()
     c->show();
 }
 
-void MainWindow::slot_addFaceItems(std::vector<QListWidgetItem*>& faces) {
-    int counter = 0;
-    for (QListWidgetItem* face : faces) {
-        QString text = "Face - " + QString::number(counter + 1);
-        face->setText(text);
-        ui->facesListWidget->addItem(face);
-        counter++;
+void MainWindow::slot_setElementCounts(int numVerts, int numHes, int numFaces, bool newMesh) {
+    if (newMesh) {
+        vertsModel->reset(numVerts);
+        halfEdgesModel->reset(numHes);
+        facesModel->reset(numFaces);
+    } else {
+        vertsModel->setCount(numVerts);
+        halfEdgesModel->setCount(numHes);
+        facesModel->setCount(numFaces);
     }
 }
 
-void MainWindow::slot_addVertexItems(std::vector<QListWidgetItem*>& vertices) {
-    int counter = 0;
-    for (QListWidgetItem* vertex : vertices) {
-        QString text = "Vertex - " + QString::number(counter + 1);
-        vertex->setText(text);
-        ui->vertsListWidget->addItem(vertex);
-        counter++;
-    }
+void MainWindow::slot_setLevels(int numLevels, int level) {
+    //the spin box follows the mesh, it shouldn't echo the level back
+    ui->levelSpinBox->blockSignals(true);
+    ui->levelSpinBox->setMaximum(numLevels - 1);
+    ui->levelSpinBox->setValue(level);
+    ui->levelSpinBox->blockSignals(false);
 }
 
-void MainWindow::slot_addHeItems(std::vector<QListWidgetItem*>& hes) {
-    int counter = 0;
-    for (QListWidgetItem* he : hes) {
-        QString text = "HalfEdge - " + QString::number(counter + 1);
-        he->setText(text);
-        ui->halfEdgesListWidget->addItem(he);
-        counter++;
-    }
+void MainWindow::slot_setEditStats(int edits, int rebuilds) {
+    ui->editStatsLabel->setText(QString("Edits: %1  Rebuilds: %2  Coalesced: %3")
+                                .arg(edits).arg(rebuilds).arg(edits - rebuilds));
 }
 
 void MainWindow::slot_addRootToTreeWidget(QTreeWidgetItem *i) {
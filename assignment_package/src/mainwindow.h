@@ -1,8 +1,9 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
-#include "component.h"
 #include <QMainWindow>
+#include <QTreeWidgetItem>
+#include "elementlistmodel.h"
 #include "smartpointerhelp.h"
 
 
@@ -24,14 +25,19 @@ private slots:
 
     void on_actionCamera_Controls_triggered();
 
-    void slot_addHeItems(std::vector<QListWidgetItem*>&);
-    void slot_addVertexItems(std::vector<QListWidgetItem*>&);
-    void slot_addFaceItems(std::vector<QListWidgetItem*>&);
+    void slot_setElementCounts(int numVerts, int numHes, int numFaces, bool newMesh);
+    void slot_setLevels(int numLevels, int level);
+    void slot_setEditStats(int edits, int rebuilds);
 
     void slot_addRootToTreeWidget(QTreeWidgetItem *i);
 
 private:
     Ui::MainWindow *ui;
+
+    //models behind the vertex, half-edge and face lists
+    ElementListModel *vertsModel;
+    ElementListModel *halfEdgesModel;
+    ElementListModel *facesModel;
 };
 
 
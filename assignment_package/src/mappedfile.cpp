@@ -0,0 +1,78 @@
+#include "mappedfile.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string& path)
+    : opened(false), ptr(nullptr), len(0), file(INVALID_HANDLE_VALUE), mapping(nullptr)
+{
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                       FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        return;
+    }
+    len = size_t(fileSize.QuadPart);
+    opened = true;
+    //an empty file can't be mapped, it just has no data
+    if (len == 0) {
+        return;
+    }
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping) {
+        ptr = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+    opened = ptr != nullptr;
+}
+
+MappedFile::~MappedFile() {
+    if (ptr) UnmapViewOfFile(ptr);
+    if (mapping) CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+}
+#else
+MappedFile::MappedFile(const std::string& path)
+    : opened(false), ptr(nullptr), len(0), fd(-1)
+{
+    fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return;
+    }
+    len = size_t(st.st_size);
+    opened = true;
+    //an empty file can't be mapped, it just has no data
+    if (len == 0) {
+        return;
+    }
+    void* mapped = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        opened = false;
+        return;
+    }
+    //the readers stream through front to back once
+    madvise(mapped, len, MADV_SEQUENTIAL);
+    ptr = static_cast<const char*>(mapped);
+}
+
+MappedFile::~MappedFile() {
+    if (ptr) munmap(const_cast<char*>(ptr), len);
+    if (fd >= 0) close(fd);
+}
+#endif
@@ -0,0 +1,30 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+
+//read-only view of a whole file, unmapped when it goes out of scope
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const { return opened; }
+    const char* data() const { return ptr; }
+    size_t size() const { return len; }
+
+private:
+    bool opened;
+    const char* ptr;
+    size_t len;
+#ifdef _WIN32
+    void* file; //HANDLEs, kept as void* so windows.h stays out of the header
+    void* mapping;
+#else
+    int fd;
+#endif
+};
+
+#endif // MAPPEDFILE_H
@@ -1,142 +1,126 @@
 #include <iostream>
+#include <algorithm>
 #include <mesh.h>
-#include <unordered_map>
+#include <parallel.h>
+#include <trace.h>
 
-Mesh::Mesh() : Drawable(nullptr), hasBeenSkinned(false) {}
+Mesh::Mesh() : Drawable(nullptr), HalfEdgeMesh(), levels(1), currentLevel(0), sharedVertices(false), hasBeenSkinned(false), skinEdited(false) {}
 
-Mesh::Mesh(OpenGLContext *context) : Drawable(context), hasBeenSkinned(false) {}
+Mesh::Mesh(OpenGLContext *context) : Drawable(context), HalfEdgeMesh(), levels(1), currentLevel(0), sharedVertices(false), hasBeenSkinned(false), skinEdited(false) {}
 
 Mesh::Mesh(OpenGLContext *context, std::vector<glm::vec3>& vertices, std::vector<glm::vec3>& normals, std::vector<std::vector<int>>& faces)
-    : Drawable(context), hasBeenSkinned(false) {
-    std::unordered_map<std::pair<Vertex*, Vertex*>, HalfEdge*, pair_hash> twinEdgeMap;
-
-    for (int i = 0; i < (int)vertices.size(); i++) {
-        uPtr<Vertex> vertex = mkU<Vertex>();
-        vertex->pos = vertices.at(i);
-        vertex->nor = normals.at(i);
-        this->addVertex(std::move(vertex));
-    }
-
-    //hes and faces
-    for (const std::vector<int>& faceIndices : faces) {
-        int numEdges = faceIndices.size();
-        std::vector<HalfEdge*> faceHalfEdges;
-
-        uPtr<Face> face = mkU<Face>();
-
-        for (int i = 0; i < numEdges; ++i) {
-            int startVertexIdx = faceIndices[i];
-            int endVertexIdx = faceIndices[(i + 1) % numEdges];
-
-            //make halfedge, set its vertex, set the vertex's he, add the edge to the face
-            uPtr<HalfEdge> he = mkU<HalfEdge>();
-            he->setVertex(this->vertices[endVertexIdx].get());
-            this->vertices[endVertexIdx]->he = he.get();
-            faceHalfEdges.push_back(he.get());
-
-            //use hash map to set syms
-            int minIdx = std::min(startVertexIdx, endVertexIdx);
-            int maxIdx = std::max(startVertexIdx, endVertexIdx);
-            std::pair<Vertex*, Vertex*> key;
-
-            key.first = this->vertices[minIdx].get();
-            key.second = this->vertices[maxIdx].get();
-            //check if edge is in map
-            if (twinEdgeMap.find(key) == twinEdgeMap.end()) {
-                //edge not in map
-                twinEdgeMap.insert({key, he.get()});
-            } else {
-                //edge in map
-                he->setSym(twinEdgeMap.at(key));
-            }
+    : Drawable(context), HalfEdgeMesh(vertices, normals, faces), levels(1), currentLevel(0), sharedVertices(false), hasBeenSkinned(false), skinEdited(false)
+{}
 
-            face->setEdge(he.get());
+Mesh::Mesh(OpenGLContext *context, const std::vector<glm::vec3>& vertices, const std::vector<glm::vec3>& normals,
+           const std::vector<uint32_t>& faceOffsets, const std::vector<uint32_t>& faceIndices)
+    : Drawable(context), HalfEdgeMesh(vertices, normals, faceOffsets, faceIndices), levels(1), currentLevel(0), sharedVertices(false), hasBeenSkinned(false), skinEdited(false)
+{}
 
-            //add half edge to mesh
-            this->addHE(std::move(he));
-        }
+int Mesh::fillFace(int f, glm::vec4* pos, glm::vec4* nor, glm::vec4* col) const {
+    uint32_t startHE = faceHE[f];
 
-        //set nexts of half edges
-        for (int i = 0; i < numEdges; ++i) {
-            int nextIdx = (i + 1) % numEdges;
-            faceHalfEdges[i]->setNext(faceHalfEdges[nextIdx]);
-        }
+    const glm::vec3 &p1 = vertPos[heVert[startHE]];
+    const glm::vec3 &p2 = vertPos[heVert[heNext[startHE]]];
+    const glm::vec3 &p3 = vertPos[heVert[heNext[heNext[startHE]]]];
+    glm::vec3 normal = glm::normalize(glm::cross(p1 - p3, p2 - p3));
 
-        float r = static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
-        float g = static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
-        float b = static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
-        face->color = glm::vec3(r, g, b);
-        this->addFace(std::move(face));
-    }
+    //one pass around the face fills the vertex attributes and counts the verts
+    int numVerts = 0;
+    uint32_t loopHE = startHE;
+    do {
+        pos[numVerts] = glm::vec4(vertPos[heVert[loopHE]], 1);
+        col[numVerts] = glm::vec4(faceColor[f], 1);
+        nor[numVerts] = glm::vec4(normal, 1);
+
+        loopHE = heNext[loopHE];
+        numVerts++;
+    } while (loopHE != startHE);
+    return numVerts;
+}
+
+glm::vec3 Mesh::areaNormal(uint32_t f) const {
+    //newell's method, works for non-planar polygons too. the length is twice
+    //the face's area, so summing these weights big faces more
+    glm::vec3 n;
+    uint32_t loopHE = faceHE[f];
+    do {
+        const glm::vec3 &a = vertPos[heVert[loopHE]];
+        const glm::vec3 &b = vertPos[heVert[heNext[loopHE]]];
+        n += glm::cross(a, b);
+        loopHE = heNext[loopHE];
+    } while (loopHE != faceHE[f]);
+    return n;
 }
 
-int Mesh::calcTotalIndices() {
-    int num = 0;
+glm::vec3 Mesh::smoothNormal(uint32_t v) const {
+    glm::vec3 n;
+    for (uint32_t c = layout.cornerOffsets[v]; c < layout.cornerOffsets[v + 1]; c++) {
+        n += areaNormal(heFace[layout.corners[c]]);
+    }
+    float len = glm::length(n);
+    return len > 0.f ? n / len : n;
+}
 
-    for (uPtr<Face>& fPtr : this->faces) {
-        HalfEdge* faceEdge = fPtr->getHE();
-        HalfEdge* next = faceEdge->next;
-        while(next != faceEdge){
-            next = next->next;
-            num++;
-        }
+void Mesh::buildCorners() {
+    //counting sort of the hes by the vertex they point to
+    std::vector<uint32_t> &offsets = layout.cornerOffsets;
+    offsets.assign(numVertices() + 1, 0);
+    for (uint32_t v : heVert) {
+        offsets[v + 1]++;
+    }
+    for (int v = 0; v < numVertices(); v++) {
+        offsets[v + 1] += offsets[v];
+    }
+    layout.corners.resize(numHes());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (int he = 0; he < numHes(); he++) {
+        layout.corners[fill[heVert[he]]++] = he;
     }
-    return 3 * (num - faces.size());
 }
 
 void Mesh::create() {
+    trace::Zone traceZone("Mesh::create", "mesh");
+    traceZone.arg("faces", numFaces());
+    buildCorners();
+    if (sharedVertices) {
+        createShared();
+    } else {
+        createPerHE();
+    }
+    clearEdits();
+    skinEdited = false;
+}
 
-    int elems = hes.size(), idx_count = calcTotalIndices();
+void Mesh::createPerHE() {
+
+    int elems = numHes(), idx_count = calcTotalIndices();
     std::vector<glm::vec4> col(elems);
     std::vector<glm::vec4> pos(elems);
     std::vector<glm::vec4> nor(elems);
     std::vector<GLuint> idx(idx_count);
 
-    std::vector<glm::ivec2> ids(elems);
-    std::vector<glm::vec2> weights(elems);
-
-    //index is used for the first part of the loop, setting up pos col and nor
-    int index = 0;
-    //baseIdx and vertex_count are used for the second part of the loop, setting up idx
-    int baseIdx = 0, vertex_count = 0;
-    for (uPtr<Face>& facePtr : this->faces) {
-        HalfEdge* faceHE = facePtr->getHE();
+    std::vector<glm::u16vec4> ids(elems);
+    std::vector<glm::u16vec4> weights(elems);
 
-        Vertex *v1 = faceHE->v, *v2 = faceHE->next->v, *v3 = faceHE->next->next->v;
-        glm::vec3 normal = glm::normalize(glm::cross(v1->pos - v3->pos, v2->pos - v3->pos));
+    layout.faceSlot.resize(numFaces());
 
-        HalfEdge* loopHE = faceHE;
-        do {
-            pos[index] = glm::vec4(loopHE->v->pos, 1);
-            col[index] = glm::vec4(facePtr->color, 1);
-            nor[index] = glm::vec4(normal, 1);
-
-            if (this->skinned()) {
-                std::vector<std::pair<Joint*, float>>& currInfluences = loopHE->v->getInfluences();
-                glm::ivec2 newId = glm::ivec2();
-                glm::vec2 newWeight = glm::vec2();
-                newId[0] = currInfluences[0].first->getId() - 1;
-                newId[1] = currInfluences[1].first->getId() - 1;
-                newWeight[0] = currInfluences[0].second;
-                newWeight[1] = currInfluences[1].second;
-                ids[index] = newId;
-                weights[index] = newWeight;
+    //baseIdx and vertex_count are used to set up idx
+    int baseIdx = 0, vertex_count = 0;
+    for (int f = 0; f < numFaces(); f++) {
+        layout.faceSlot[f] = vertex_count;
+        int numVerts = fillFace(f, &pos[vertex_count], &nor[vertex_count], &col[vertex_count]);
+
+        if (this->skinned()) {
+            uint32_t loopHE = faceHE[f];
+            for (int j = 0; j < numVerts; j++) {
+                ids[vertex_count + j] = vertJointIds[heVert[loopHE]];
+                weights[vertex_count + j] = vertJointWeights[heVert[loopHE]];
+                loopHE = heNext[loopHE];
             }
+        }
 
-            loopHE = loopHE->next;
-            index++;
-        } while (loopHE != faceHE);
-
-        //loop part 2! time for idx
-        //step 1 - count da verts
-        int numVerts = 0;
-        loopHE = faceHE;
-        do {
-            numVerts++;
-            loopHE = loopHE->getNext();
-        } while (loopHE != faceHE);
-
-        //step 2 - use vert count to place verts in the right spot in idx
+        //use vert count to place verts in the right spot in idx
         for (int j = 2; j < numVerts; j++) {
             int startIdx = baseIdx * 3;
             idx[startIdx] = vertex_count;
@@ -148,454 +132,434 @@ void Mesh::create() {
         vertex_count += numVerts;
     }
 
-    count = calcTotalIndices();
-
-    if (this->skinned()) {
-        generateIds();
-        mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufIds);
-        mp_context->glBufferData(GL_ARRAY_BUFFER, ids.size() * sizeof(glm::ivec2), ids.data(), GL_STATIC_DRAW);
-
-        generateWeights();
-        mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufWeights);
-        mp_context->glBufferData(GL_ARRAY_BUFFER, weights.size() * sizeof(glm::vec2), weights.data(), GL_STATIC_DRAW);
-    }
-
-    generateIdx();
-    mp_context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufIdx);
-    mp_context->glBufferData(GL_ELEMENT_ARRAY_BUFFER, idx.size() * sizeof(GLuint), idx.data(), GL_STATIC_DRAW);
-
-    generatePos();
-    mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufPos);
-    mp_context->glBufferData(GL_ARRAY_BUFFER, pos.size() * sizeof(glm::vec4), pos.data(), GL_STATIC_DRAW);
-
-    generateNor();
-    mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufNor);
-    mp_context->glBufferData(GL_ARRAY_BUFFER, nor.size() * sizeof(glm::vec4), nor.data(), GL_STATIC_DRAW);
-
-    generateCol();
-    mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufCol);
-    mp_context->glBufferData(GL_ARRAY_BUFFER, col.size() * sizeof(glm::vec4), col.data(), GL_STATIC_DRAW);
-}
+    count = idx_count;
+    vecSize = 4;
 
-GLenum Mesh::drawMode() {
-    return GL_TRIANGLES;
+    upload(idx, pos.data(), nor.data(), col.data(), pos.size() * sizeof(glm::vec4), ids, weights);
 }
 
-void Mesh::addFace(uPtr<Face> fPtr) {
-    this->faces.push_back(std::move(fPtr));
-}
+void Mesh::createShared() {
+    const int numVerts = numVertices();
+
+    //a vertex gets one gpu vertex per distinct color among its faces. colors
+    //are inherited through subdivision, so seams only run along the borders
+    //of the faces the colors came from
+    std::vector<uint32_t> &vertSlots = layout.vertSlots;
+    vertSlots.assign(numVerts + 1, 0);
+    auto firstWithColor = [this](uint32_t begin, uint32_t c) {
+        const glm::vec3 &color = faceColor[heFace[layout.corners[c]]];
+        uint32_t k = begin;
+        while (faceColor[heFace[layout.corners[k]]] != color) {
+            k++;
+        }
+        return k;
+    };
+    parallel::forEach(numVerts, [&](int v) {
+        uint32_t distinct = 0;
+        for (uint32_t c = layout.cornerOffsets[v]; c < layout.cornerOffsets[v + 1]; c++) {
+            distinct += firstWithColor(layout.cornerOffsets[v], c) == c;
+        }
+        vertSlots[v + 1] = distinct;
+    });
+    for (int v = 0; v < numVerts; v++) {
+        vertSlots[v + 1] += vertSlots[v];
+    }
 
-void Mesh::addVertex(uPtr<Vertex> vPtr) {
-    this->vertices.push_back(std::move(vPtr));
-}
+    const int numSlots = vertSlots[numVerts];
+    std::vector<glm::vec3> pos(numSlots), nor(numSlots), col(numSlots);
+    std::vector<glm::u16vec4> ids(this->skinned() ? numSlots : 0);
+    std::vector<glm::u16vec4> weights(this->skinned() ? numSlots : 0);
+    std::vector<uint32_t> heSlot(numHes());
+
+    parallel::forEach(numVerts, [&](int v) {
+        glm::vec3 normal = smoothNormal(v);
+        uint32_t begin = layout.cornerOffsets[v], slot = vertSlots[v];
+        for (uint32_t c = begin; c < layout.cornerOffsets[v + 1]; c++) {
+            uint32_t first = firstWithColor(begin, c);
+            if (first != c) {
+                heSlot[layout.corners[c]] = heSlot[layout.corners[first]];
+                continue;
+            }
+            pos[slot] = vertPos[v];
+            nor[slot] = normal;
+            col[slot] = faceColor[heFace[layout.corners[c]]];
+            if (this->skinned()) {
+                ids[slot] = vertJointIds[v];
+                weights[slot] = vertJointWeights[v];
+            }
+            heSlot[layout.corners[c]] = slot++;
+        }
+    });
+
+    //fan triangulate each face over its corners' shared vertices
+    std::vector<GLuint> idx(calcTotalIndices());
+    int baseIdx = 0;
+    for (int f = 0; f < numFaces(); f++) {
+        uint32_t first = heSlot[faceHE[f]];
+        uint32_t loopHE = heNext[faceHE[f]];
+        for (uint32_t next = heNext[loopHE]; next != faceHE[f]; next = heNext[next]) {
+            idx[baseIdx++] = first;
+            idx[baseIdx++] = heSlot[loopHE];
+            idx[baseIdx++] = heSlot[next];
+            loopHE = next;
+        }
+    }
 
-void Mesh::addHE(uPtr<HalfEdge> hePtr) {
-    this->hes.push_back(std::move(hePtr));
-}
+    count = idx.size();
+    vecSize = 3;
 
-bool Mesh::hasVertices() const {
-    return !this->vertices.empty();
+    upload(idx, pos.data(), nor.data(), col.data(), pos.size() * sizeof(glm::vec3), ids, weights);
 }
 
-std::vector<uPtr<Vertex>>& Mesh::getVertices() {
-    return this->vertices;
-}
+void Mesh::upload(const std::vector<GLuint>& idx, const void* pos, const void* nor, const void* col, GLsizeiptr attrBytes,
+                  const std::vector<glm::u16vec4>& ids, const std::vector<glm::u16vec4>& weights) {
+    //the buffers are refilled in place for as long as the data fits
+    if (this->skinned()) {
+        Drawable::upload(bufIds, ids);
+        Drawable::upload(bufWeights, weights);
+    } else {
+        bufIds.reset();
+        bufWeights.reset();
+    }
 
-std::vector<uPtr<Face>>& Mesh::getFaces() {
-    return this->faces;
+    Drawable::upload(bufIdx, idx);
+    Drawable::upload(bufPos, pos, attrBytes, GL_DYNAMIC_DRAW);
+    Drawable::upload(bufNor, nor, attrBytes, GL_DYNAMIC_DRAW);
+    Drawable::upload(bufCol, col, attrBytes, GL_DYNAMIC_DRAW);
 }
 
-std::vector<uPtr<HalfEdge>>& Mesh::getHes() {
-    return this->hes;
+bool Mesh::updateBuffers() {
+    TRACE_ZONE("Mesh::updateBuffers", "mesh");
+    if (topologyEdited || skinEdited || count < 0) {
+        create();
+        return true;
+    }
+    if (editedVerts.empty() && editedFaces.empty()) {
+        return false;
+    }
+    if (sharedVertices) {
+        updateShared();
+    } else {
+        updatePerHE();
+    }
+    clearEdits();
+    return true;
 }
 
-Vertex& Mesh::splitEdge(HalfEdge* he1) {
-    HalfEdge* he2 = he1->sym;
-    Vertex* v1 = he1->v;
-    Vertex* v2 = he2->v;
-    uPtr<Vertex> v3 = mkU<Vertex>();
-    v3->pos = (v2->pos + v1->pos) / 2.f;
-    //v3 has average pos of vert before and after he
-    uPtr<HalfEdge> he1b = mkU<HalfEdge>(), he2b = mkU<HalfEdge>();
-
-    he1b->v = v1;
-    he2b->v = v2;
-
-    v1->he = he1b.get();
-    v2->he = he2b.get();
-
-    he1b->setFace(he1->face);
-    he2b->setFace(he2->face);
-
-    he1b->next = he1->next;
-    he2b->next = he2->next;
-
-    he1->next = he1b.get();
-    he2->next = he2b.get();
-
-    he1->v = v3.get();
-    he2->v = v3.get();
-
-    v3->he = he1;
-
-    he1->setSym(he2b.get());
-    he2->setSym(he1b.get());
-
-    Vertex &ret = *v3;
+void Mesh::updatePerHE() {
+    //a moved vertex changes its own gpu copies and the normals of every face
+    //around it, so the faces are what gets patched
+    std::vector<uint32_t> faces(editedFaces);
+    for (uint32_t v : editedVerts) {
+        for (uint32_t c = layout.cornerOffsets[v]; c < layout.cornerOffsets[v + 1]; c++) {
+            faces.push_back(heFace[layout.corners[c]]);
+        }
+    }
+    std::sort(faces.begin(), faces.end());
+    faces.erase(std::unique(faces.begin(), faces.end()), faces.end());
 
-    this->addVertex(std::move(v3));
-    this->addHE(std::move(he1b));
-    this->addHE(std::move(he2b));
+    //past this many faces one big upload beats lots of small ones
+    if (faces.size() > (size_t)numFaces() / 4) {
+        create();
+        return;
+    }
 
-    return ret;
+    //faces are stored in face order, so consecutive faces are consecutive
+    //gpu ranges. each run of them goes up in one glBufferSubData per attribute
+    std::vector<glm::vec4> pos, nor, col;
+    for (size_t i = 0; i < faces.size();) {
+        uint32_t firstSlot = layout.faceSlot[faces[i]];
+        pos.clear();
+        nor.clear();
+        col.clear();
+        size_t j = i;
+        for (; j < faces.size() && (j == i || faces[j] == faces[j - 1] + 1); j++) {
+            size_t at = pos.size();
+            int valence = getValence(FaceHandle(faces[j]));
+            pos.resize(at + valence);
+            nor.resize(at + valence);
+            col.resize(at + valence);
+            fillFace(faces[j], &pos[at], &nor[at], &col[at]);
+        }
+        i = j;
+
+        GLintptr offset = firstSlot * sizeof(glm::vec4);
+        GLsizeiptr size = pos.size() * sizeof(glm::vec4);
+        mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufPos.id());
+        mp_context->glBufferSubData(GL_ARRAY_BUFFER, offset, size, pos.data());
+        mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufNor.id());
+        mp_context->glBufferSubData(GL_ARRAY_BUFFER, offset, size, nor.data());
+        mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufCol.id());
+        mp_context->glBufferSubData(GL_ARRAY_BUFFER, offset, size, col.data());
+    }
 }
 
-void Mesh::triangulateFace(Face* f) {
-    int numVerts = 0;
-    HalfEdge* loopHE = f->he;
-    do {
-        numVerts++;
-        loopHE = loopHE->getNext();
-    } while (loopHE != f->he);
-
-    if (numVerts <= 3) {
+void Mesh::updateShared() {
+    //a recolored face can move seams, that's a new layout
+    if (!editedFaces.empty()) {
+        create();
         return;
     }
 
-    HalfEdge* he_0 = f->he;
-
-    for (int i = 0; i < numVerts - 3; i++) {
-        uPtr<HalfEdge> he_a = mkU<HalfEdge>(), he_b = mkU<HalfEdge>();
-
-        he_a->v = he_0 ->v;
-        he_b->v = he_0->next->next->v;
-        he_a->setSym(he_b.get());
-        uPtr<Face> f2 = mkU<Face>();
-        he_a->setFace(f2.get());
-        he_0->next->setFace(f2.get());
-        he_0->next->next->setFace(f2.get());
-        he_b->setFace(f);
-        he_b->next = he_0->next->next->next;
-        he_0->next->next->next = he_a.get();
-        he_a->next = he_0->next;
-        he_0->next = he_b.get();
-
-        f2->color = f->color;
-
-        this->addHE(std::move(he_a));
-        this->addHE(std::move(he_b));
-        this->addFace(std::move(f2));
-
-        he_0 = he_0->next;
-    }
-}
-
-void Mesh::catmullclarkSubdivision() {
-
-    std::vector<Vertex*> originalVertices;
-    for(auto& v : this->vertices) {
-        originalVertices.push_back(v.get());
-    }
-
-    //step 1: calculate centroids
-    std::unordered_map<Face*, Vertex*, single_hash> faceCentroidMap;
-    for (uPtr<Face>& fPtr : faces) {
-        float numVerts = 0.f;
-        glm::vec3 avgPos;
-        HalfEdge* loopHE = fPtr->he;
-        do {
-            //counts number of vertices, gets the pos to add to avgPog, and goes to next he
-            numVerts++;
-            avgPos += loopHE->getVertex()->pos;
-            loopHE = loopHE->getNext();
-        } while (loopHE != fPtr->he);
-        avgPos /= numVerts;
-        uPtr<Vertex> vPtr = mkU<Vertex>();
-        vPtr->pos = avgPos;
-        faceCentroidMap.insert({fPtr.get(), vPtr.get()});
-        this->addVertex(std::move(vPtr));
-    }
-
-    //step 2: calculate smoothed midpoints
-    //e = (v1 + v2 + f1 + f2) / 4
-    //midpoints should be pushed back
-    //map with edges and vertex so i don't split the same edge twice
-    //add the edge and its sym to the map when its split
-    std::unordered_map<HalfEdge*, Vertex*, single_hash> heMidptMap;
-    std::vector<HalfEdge*> originalHEs;
-    for (auto& hePtr : hes) {
-        originalHEs.push_back(hePtr.get());
-    }
-    for (HalfEdge* hePtr : originalHEs) {
-        //if haven't already split this HE
-        if (heMidptMap.find(hePtr) == heMidptMap.end()) {
-            Vertex* v1 = hePtr->v;
-            Vertex* v2 = hePtr->sym->v;
-            Vertex* f1 = faceCentroidMap.at(hePtr->face);
-            Vertex* f2 = faceCentroidMap.at(hePtr->sym->face);
-            heMidptMap.insert({hePtr, nullptr});
-            heMidptMap.insert({hePtr->sym, nullptr});
-            Vertex &newVert = this->splitEdge(hePtr);
-            newVert.pos = (v1->pos + v2->pos + f1->pos + f2->pos) / 4.f;
+    //a moved vertex changes the normals of every vertex on the faces around it
+    std::vector<uint32_t> verts;
+    for (uint32_t v : editedVerts) {
+        for (uint32_t c = layout.cornerOffsets[v]; c < layout.cornerOffsets[v + 1]; c++) {
+            uint32_t start = layout.corners[c], loopHE = start;
+            do {
+                verts.push_back(heVert[loopHE]);
+                loopHE = heNext[loopHE];
+            } while (loopHE != start);
         }
     }
+    std::sort(verts.begin(), verts.end());
+    verts.erase(std::unique(verts.begin(), verts.end()), verts.end());
 
-    //step 3: smooth the original vertices
-    //v' = (n-2)v/n +
-    //     sum(e)/n^2 +
-    //     sum(f)/n^2
-    for (Vertex* vPtr : originalVertices) {
-        glm::vec3 sumCentroids = glm::vec3();
-        glm::vec3 sumMidpts = glm::vec3();
-
-        HalfEdge *loopHE = vPtr->he;
-
-        //loopHE should now be the he pointing into the vertex
-
-        float n = 0.f;
-        do {
-            Vertex* c = faceCentroidMap.at(loopHE->face);
-            sumCentroids += c->pos;
-
-            Vertex* midpt = loopHE->sym->v;
-            sumMidpts += midpt->pos;
+    if (verts.size() > (size_t)numVertices() / 4) {
+        create();
+        return;
+    }
 
-            loopHE = loopHE->next;
-            loopHE = loopHE->sym;
+    //a vertex's gpu copies are contiguous and vertices are laid out in
+    //order, so runs of consecutive vertices are runs of consecutive slots
+    std::vector<glm::vec3> pos, nor;
+    for (size_t i = 0; i < verts.size();) {
+        uint32_t firstSlot = layout.vertSlots[verts[i]];
+        pos.clear();
+        nor.clear();
+        size_t j = i;
+        for (; j < verts.size() && (j == i || verts[j] == verts[j - 1] + 1); j++) {
+            uint32_t v = verts[j];
+            glm::vec3 normal = smoothNormal(v);
+            for (uint32_t slot = layout.vertSlots[v]; slot < layout.vertSlots[v + 1]; slot++) {
+                pos.push_back(vertPos[v]);
+                nor.push_back(normal);
+            }
+        }
+        i = j;
+        if (pos.empty()) {
+            continue;
+        }
 
-            n++;
-        } while (loopHE != vPtr->he);
-        //smooth vertex using equation from slides
-        vPtr->pos = (n - 2.f) * vPtr->pos / n +
-                     sumMidpts / (n * n) +
-                     sumCentroids / (n * n);
+        GLintptr offset = firstSlot * sizeof(glm::vec3);
+        GLsizeiptr size = pos.size() * sizeof(glm::vec3);
+        mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufPos.id());
+        mp_context->glBufferSubData(GL_ARRAY_BUFFER, offset, size, pos.data());
+        mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufNor.id());
+        mp_context->glBufferSubData(GL_ARRAY_BUFFER, offset, size, nor.data());
     }
+}
 
-    std::vector<Face*> originalFaces;
-    for(auto& f : this->faces) {
-        originalFaces.push_back(f.get());
+void Mesh::setSharedVertices(bool shared) {
+    if (shared == sharedVertices) {
+        return;
     }
-
-    //step 4: quadrangulate faces
-    //face's he should be pointing to an og vertex, not a midpt
-    for (Face* fPtr : originalFaces) {
-        std::vector<HalfEdge*> hesToMidpts;
-        HalfEdge* loopHE = fPtr->he->next;
-        do {
-            hesToMidpts.push_back(loopHE);
-            loopHE = loopHE->getNext()->getNext();
-        } while (loopHE != fPtr->he->next);
-        //use method idea from slides
-        quadrangulateFace(fPtr, faceCentroidMap.at(fPtr), hesToMidpts);
+    sharedVertices = shared;
+    //the cached levels were uploaded in the other layout
+    for (int k = 0; k < numLevels(); k++) {
+        if (k != currentLevel) {
+            levels[k].upToDate = false;
+        }
+    }
+    if (count >= 0) {
+        create();
     }
 }
 
+bool Mesh::usesSharedVertices() const {
+    return sharedVertices;
+}
 
-void Mesh::quadrangulateFace(Face* f, Vertex* centroid, std::vector<HalfEdge*>& hesToMidpts) {
-    HalfEdge *prevTo, *firstFrom;
-    bool firstIter = true;
-    for (HalfEdge* hePtr : hesToMidpts) {
-        HalfEdge* first = hePtr;
-
-        //sym next until the next of the one we are on is the original
-        HalfEdge* prev = hePtr;
-        do {
-            prev = prev->sym;
-            if (prev->next != hePtr) {
-                prev = prev->next;
-            }
-        } while (prev->next != hePtr);
+GLenum Mesh::drawMode() {
+    return GL_TRIANGLES;
+}
 
-        uPtr<HalfEdge> toCentroid = mkU<HalfEdge>(), fromCentroid = mkU<HalfEdge>();
-        uPtr<Face> newFace = mkU<Face>();
-        Face* faceToMake = firstIter ? f : newFace.get();
+GLsizeiptr Mesh::gpuBytes() const {
+    GLsizeiptr bytes = Drawable::gpuBytes();
+    for (const MeshLevel& level : levels) {
+        bytes += level.bufIdx.capacity() + level.bufPos.capacity() + level.bufNor.capacity()
+               + level.bufCol.capacity() + level.bufIds.capacity() + level.bufWeights.capacity();
+    }
+    return bytes;
+}
 
-        //reset first's next
-        first->next = toCentroid.get();
+void Mesh::swapLevel(int k) {
+    MeshLevel &level = levels[k];
+    std::swap(static_cast<HalfEdgeMesh&>(*this), level.topology);
+    std::swap(bufIdx, level.bufIdx);
+    std::swap(bufPos, level.bufPos);
+    std::swap(bufNor, level.bufNor);
+    std::swap(bufCol, level.bufCol);
+    std::swap(bufIds, level.bufIds);
+    std::swap(bufWeights, level.bufWeights);
+    std::swap(count, level.count);
+    std::swap(layout, level.layout);
+}
 
-        //set to edge's next and v and the centroid's he
-        toCentroid->v = centroid;
-        toCentroid->next = fromCentroid.get();
-        centroid->he = toCentroid.get();
+void Mesh::deleteBuffers(MeshLevel& level) {
+    level.bufIdx.reset();
+    level.bufPos.reset();
+    level.bufNor.reset();
+    level.bufCol.reset();
+    level.bufIds.reset();
+    level.bufWeights.reset();
+}
 
-        //set from edge's next and v
-        fromCentroid->next = prev;
-        fromCentroid->v = prev->sym->v;
+void Mesh::subdivide() {
+    TRACE_ZONE("Mesh::subdivide", "mesh");
+    if (currentLevel + 1 < numLevels()) {
+        setLevel(currentLevel + 1);
+        return;
+    }
 
-        //faces
-        toCentroid->setFace(faceToMake);
-        fromCentroid->setFace(faceToMake);
-        first->setFace(faceToMake);
-        prev->setFace(faceToMake);
+    //park a copy of this level with its vbos, the new level gets fresh ones
+    MeshLevel &parked = levels[currentLevel];
+    parked.topology = static_cast<const HalfEdgeMesh&>(*this);
+    parked.bufIdx = std::move(bufIdx);
+    parked.bufPos = std::move(bufPos);
+    parked.bufNor = std::move(bufNor);
+    parked.bufCol = std::move(bufCol);
+    parked.bufIds = std::move(bufIds);
+    parked.bufWeights = std::move(bufWeights);
+    parked.count = count;
+    parked.layout = layout;
+    //edits that haven't been flushed to the vbos yet get picked up when
+    //the level is switched back to
+    parked.upToDate = !hasEdits();
+
+    levels.push_back(MeshLevel());
+    currentLevel++;
+    catmullclarkSubdivision();
+    create();
+}
 
-        //color
-        faceToMake->color = f->color;
+void Mesh::setLevel(int level) {
+    if (level == currentLevel || level < 0 || level >= numLevels()) {
+        return;
+    }
+    bool upToDate = levels[level].upToDate;
+    bool parkedUpToDate = !hasEdits();
+    //park the active level in its slot and take the requested one out of its
+    //own, both are just vector and handle swaps
+    swapLevel(level);
+    std::swap(levels[currentLevel], levels[level]);
+    levels[currentLevel].upToDate = parkedUpToDate;
+    currentLevel = level;
+    if (!upToDate) {
+        create();
+    }
+}
 
-        if (!firstIter) {
-            //set syms of to and from centroid edges
-            fromCentroid->setSym(prevTo);
-        } else {
-            //it is the first iteration, set the first from edge for setting its sym
-            //at the end and set firstIter to false
-            firstFrom = fromCentroid.get();
-        }
+int Mesh::getLevel() const {
+    return currentLevel;
+}
 
-        prevTo = toCentroid.get();
+int Mesh::numLevels() const {
+    return levels.size();
+}
 
-        //add stuff to mesh
-        if (!firstIter) {
-            this->addFace(std::move(newFace));
-        } else {
-            firstIter = false;
-        }
-        this->addHE(std::move(toCentroid));
-        this->addHE(std::move(fromCentroid));
+void Mesh::invalidateFinerLevels() {
+    for (int k = currentLevel + 1; k < numLevels(); k++) {
+        deleteBuffers(levels[k]);
     }
-    firstFrom->setSym(prevTo);
+    levels.resize(currentLevel + 1);
 }
 
-void Mesh::extrudeFace(Face* f) {
-    std::vector<HalfEdge*> faceHes;
-    HalfEdge* loopHE = f->he;
-    std::vector<Vertex*> ogVerts;
-
-    //loop gets verts for normal calculation and stores the face's hes in faceHes
-    do {
-        loopHE = loopHE->next;
-        faceHes.push_back(loopHE);
-    } while (loopHE != f->he);
-
-    //calculate normal
-    glm::vec3 normal = glm::normalize(glm::cross(f->he->next->v->pos - f->he->v->pos,
-                                                 f->he->next->next->v->pos - f->he->next->v->pos));
-
-    //make one new vertex for each he
-    std::vector<Vertex*> newVerts;
-    for (int i = 0; i < (int)faceHes.size(); i++) {
-        uPtr<Vertex> newVert = mkU<Vertex>();
-        newVerts.push_back(newVert.get());
-        this->addVertex(std::move(newVert));
-    }
-
-    //vector for edges that will be in the top face
-    std::vector<HalfEdge*> topEdges;
-
-    bool firstIter = true;
-    HalfEdge *prevHE2, *firstHE1;
-
-    //make a face for each edge in faceHes
-    for (int i = 0; i < (int)faceHes.size(); i++) {
-        HalfEdge* ogHe = faceHes[i];
-        Vertex* ogV1 = ogHe->sym->v;
-        Vertex* ogV2 = ogHe->v;
-        uPtr<Face> newFace = mkU<Face>();
-        Vertex *v1 = newVerts[i], *v2 = newVerts[(i + 1) % newVerts.size()];
-
-        //he1's sym will have to be set to the prev he2
-        //he1 points into ogHe base vert
-        //he2 points out of ogHe vert
-        //he3 points into base of he1(top edge
-        uPtr<HalfEdge> he1 = mkU<HalfEdge>(), he2 = mkU<HalfEdge>(), he3 = mkU<HalfEdge>();
-
-        he1->v = ogV1;
-        he2->v = v2;
-        he3->v = v1;
-
-        v1->pos = ogV1->pos + normal * 0.5f;
-        v2->pos = ogV2->pos + normal * 0.5f;
-
-        v1->he = he3.get();
-        v2->he = he2.get();
-
-        //set nexts of edges
-        ogHe->setNext(he2.get());
-        he2->setNext(he3.get());
-        he3->setNext(he1.get());
-        he1->setNext(ogHe);
-
-        //set face pointers
-        ogHe->setFace(newFace.get());
-        he1->setFace(newFace.get());
-        he2->setFace(newFace.get());
-        he3->setFace(newFace.get());
-
-        //he3 will need to be kept track of for making the top face
-        topEdges.push_back(he3.get());
-
-        if (firstIter) {
-            firstIter = false;
-            firstHE1 = he1.get();
-        } else {
-            prevHE2->setSym(he1.get());
+void Mesh::vertexEdited(VertexHandle v) {
+    if (!hasStencils() || (int)v.idx >= numControlVertices()) {
+        invalidateFinerLevels();
+        return;
+    }
+    //every cached level with stencils was subdivided from the same cage,
+    //cage vertices keep their index at every level
+    glm::vec3 pos = getControlPos(v);
+    for (int k = 0; k < numLevels(); k++) {
+        HalfEdgeMesh &topology = levels[k].topology;
+        if (k != currentLevel && topology.hasStencils()) {
+            topology.setPos(v, pos);
+            levels[k].upToDate = false;
         }
-
-        prevHE2 = he2.get();
-
-        newFace->color = f->color;
-
-        //add stuff to mesh
-        this->addFace(std::move(newFace));
-        this->addHE(std::move(he1));
-        this->addHE(std::move(he2));
-        this->addHE(std::move(he3));
     }
+}
 
-    firstHE1->setSym(prevHE2);
-
-    //handle top face
-    std::vector<HalfEdge*> newTopEdges;
-    for (int i = 0; i < (int)topEdges.size(); i++) {
-        uPtr<HalfEdge> newTopEdge = mkU<HalfEdge>();
-        newTopEdge->setFace(f);
-        newTopEdge->setSym(topEdges[i]);
-        newTopEdge->v = topEdges[i]->next->next->next->v;
-        newTopEdges.push_back(newTopEdge.get());
-        this->addHE(std::move(newTopEdge));
+void Mesh::clearLevels() {
+    for (int k = 0; k < numLevels(); k++) {
+        if (k != currentLevel) {
+            deleteBuffers(levels[k]);
+        }
     }
+    levels.clear();
+    levels.resize(1);
+    currentLevel = 0;
+}
 
-    //set nexts for top face
-    for (int i = 0; i < (int)newTopEdges.size(); i++) {
-        newTopEdges[i]->next = newTopEdges[(i + 1) % newTopEdges.size()];
+void Mesh::startCage() {
+    enableStencils();
+    //coarser levels aren't built from this cage and finer ones don't know it
+    for (int k = 0; k < currentLevel; k++) {
+        levels[k].topology.clearStencils();
     }
+    invalidateFinerLevels();
 }
 
-void Mesh::setRootJoint(uPtr<Joint> newRoot) {
-    this->joint = std::move(newRoot);
+void Mesh::stopCage() {
+    clearStencils();
+    for (MeshLevel &level : levels) {
+        level.topology.clearStencils();
+    }
 }
 
-void Mesh::findVertJointsRec(Vertex* v, Joint* curr, std::array<Joint*, 2>& jointArr, std::array<float, 2>& dists) {
-    curr->updateBindMat();
+void Mesh::setSkeleton(const Skeleton& skeleton) {
+    joints.clear();
+    joint.reset();
+    pose = mkU<SkeletonPose>(skeleton);
+
+    //the influences index the old skeleton's joints and were bound to its
+    //pose, so the mesh is unskinned until it's bound to this one
+    if (hasBeenSkinned) {
+        clearInfluences();
+        hasBeenSkinned = false;
+        skinEdited = true;
+    }
 
-    float currDist = glm::distance(glm::vec4(v->getPos(), 1), curr->getOverallTransformation() * glm::vec4(0,0,0,1));
-    if (currDist < std::max(dists[0], dists[1])) {
-        if (dists[0] > dists[1]) {
-            dists[0] = currDist;
-            jointArr[0] = curr;
+    //parents come first, so every joint's parent already exists to take it
+    for (int j = 0; j < skeleton.numJoints(); j++) {
+        uPtr<Joint> curr = mkU<Joint>(pose.get(), j, QString::fromStdString(skeleton.names[j]));
+        joints.push_back(curr.get());
+        if (skeleton.parents[j] < 0) {
+            joint = std::move(curr);
         } else {
-            dists[1] = currDist;
-            jointArr[1] = curr;
+            joints[skeleton.parents[j]]->addChild(std::move(curr));
         }
     }
-    for (uPtr<Joint>& child : curr->getChildren()) {
-        findVertJointsRec(v, child.get(), jointArr, dists);
-    }
 }
 
-void Mesh::skinMesh() {
-    for (int i = 0; i < (int) vertices.size();i++) {
-        std::array<Joint*, 2> joints;
-        std::array<float, 2> dists = {FLT_MAX, FLT_MAX};
-
-        findVertJointsRec(vertices[i].get(), this->joint.get(), joints, dists);
-
-        float total = dists[0] + dists[1];
-        dists[0] /= total;
-        dists[1] /= total;
-
-        vertices[i]->addInfluence(joints[0], dists[0]);
-        vertices[i]->addInfluence(joints[1], dists[1]);
+void Mesh::skinMesh(bool toBones, int maxInfluences) {
+    if (!hasJoints()) {
+        return;
+    }
+    TRACE_ZONE("Mesh::skinMesh", "mesh");
+    pose->bind();
+
+    //joint ids are the pose's indices, which is also where each joint's
+    //matrices sit in the shader's arrays
+    std::vector<glm::vec3> jointPos(numJoints());
+    std::vector<int> jointParents(numJoints()), jointIds(numJoints());
+    for (int j = 0; j < numJoints(); j++) {
+        jointPos[j] = pose->getWorldPosition(j);
+        jointParents[j] = pose->getParent(j);
+        jointIds[j] = j;
     }
+    if (toBones) {
+        bindNearestBones(jointPos, jointParents, jointIds, maxInfluences);
+    } else {
+        bindNearestJoints(jointPos, jointIds, maxInfluences);
+    }
+
     this->hasBeenSkinned = true;
+    this->skinEdited = true;
+    //only this level has influences, the cached ones can't be drawn skinned
+    clearLevels();
 }
 
 bool Mesh::hasJoints() const {
@@ -606,6 +570,18 @@ Joint* Mesh::getRoot() const {
     return this->joint.get();
 }
 
+int Mesh::numJoints() const {
+    return joints.size();
+}
+
+Joint* Mesh::getJoint(int j) const {
+    return joints[j];
+}
+
+SkeletonPose& Mesh::getPose() {
+    return *pose;
+}
+
 bool Mesh::skinned() const {
     return this->hasBeenSkinned;
 }
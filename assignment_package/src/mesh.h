@@ -3,71 +3,129 @@
 
 #include <la.h>
 #include <smartpointerhelp.h>
-#include <component.h>
+#include <halfedgemesh.h>
 #include <drawable.h>
+#include "joint.h"
 
-class Mesh : public Drawable {
+//the renderable mesh. all of the topology and the mesh operators live in
+//HalfEdgeMesh, this class adds the VBOs and the skeleton
+class Mesh : public Drawable, public HalfEdgeMesh {
 private:
-    std::vector<uPtr<Vertex>> vertices;
-    std::vector<uPtr<Face>> faces;
-    std::vector<uPtr<HalfEdge>> hes;
-    //quadrangulates a face using a face pointer, a centroid of that faces, and the hes pointing to midpoints on that face
-    void quadrangulateFace(Face* f, Vertex* centroid, std::vector<HalfEdge*>& hes);
+    //where each element landed in the vbos, rebuilt by create()
+    struct BufferLayout {
+        //the hes pointing into vertex v are corners[cornerOffsets[v]] up to
+        //corners[cornerOffsets[v + 1]]
+        std::vector<uint32_t> cornerOffsets;
+        std::vector<uint32_t> corners;
+        //per-he layout: first gpu vertex of each face, one gpu vertex per he
+        std::vector<uint32_t> faceSlot;
+        //shared layout: vertex v's gpu vertices are vertSlots[v] up to vertSlots[v + 1]
+        std::vector<uint32_t> vertSlots;
+    };
 
-    //added for hw 7
+    //a subdivision level that isn't on screen, parked along with the vbos
+    //it was last drawn with so switching back to it costs nothing
+    struct MeshLevel {
+        HalfEdgeMesh topology;
+        GLBuffer bufIdx, bufPos, bufNor, bufCol, bufIds, bufWeights;
+        int count = -1;
+        BufferLayout layout;
+        bool upToDate = false; //false when the vbos no longer match the topology
+    };
+
+    //levels[0] is the coarsest. the active level lives in this mesh itself,
+    //its slot in levels is left empty
+    std::vector<MeshLevel> levels;
+    int currentLevel;
+
+    //vbo layout, which is also the shading mode. the per-he layout gives
+    //every he its own gpu vertex so faces get flat normals and their own
+    //colors. the shared layout gives each vertex one gpu vertex per face
+    //color around it with a smooth normal, which is what lets corners share
+    bool sharedVertices;
+    BufferLayout layout;
+
+    //added for hw 7. the pose holds every joint's transforms, the joints
+    //are its tree widget rows, owned as a tree rooted at joint and listed in the
+    //pose's order in joints. the pose is on the heap so the joints' pointers
+    //to it survive the mesh being moved
+    uPtr<SkeletonPose> pose;
     uPtr<Joint> joint;
+    std::vector<Joint*> joints;
     bool hasBeenSkinned;
+    //skinMesh() changed the influences, which only create() uploads
+    bool skinEdited;
+
+    //writes face f's gpu vertices starting at its faceHE, returns how many
+    int fillFace(int f, glm::vec4* pos, glm::vec4* nor, glm::vec4* col) const;
+    //face normal scaled by twice the face's area
+    glm::vec3 areaNormal(uint32_t f) const;
+    //area weighted average of the normals of the faces around v
+    glm::vec3 smoothNormal(uint32_t v) const;
+
+    void buildCorners();
+    void createPerHE();
+    void createShared();
+    void updatePerHE();
+    void updateShared();
+    void upload(const std::vector<GLuint>& idx, const void* pos, const void* nor, const void* col, GLsizeiptr attrBytes,
+                const std::vector<glm::u16vec4>& ids, const std::vector<glm::u16vec4>& weights);
+
+    //swaps the active level's topology and vbos with levels[k]
+    void swapLevel(int k);
+    void deleteBuffers(MeshLevel& level);
 public:
     Mesh();
     Mesh(OpenGLContext *context);
     Mesh(OpenGLContext *context, std::vector<glm::vec3>& vertices, std::vector<glm::vec3>& normals, std::vector<std::vector<int>>& faces);
+    Mesh(OpenGLContext *context, const std::vector<glm::vec3>& vertices, const std::vector<glm::vec3>& normals,
+         const std::vector<uint32_t>& faceOffsets, const std::vector<uint32_t>& faceIndices);
 
+    //full rebuild of every vbo
     void create() override;
+    //patches just the edited vertices and faces into the vbos with
+    //glBufferSubData, falls back to create() after a topology change or a
+    //skinning. returns false if nothing needed uploading
+    bool updateBuffers();
     GLenum drawMode() override;
+    //the active level's vbos plus every cached level's
+    GLsizeiptr gpuBytes() const override;
 
-    void addFace(uPtr<Face> fPtr);
-    void addVertex(uPtr<Vertex> vPtr);
-    void addHE(uPtr<HalfEdge> hePtr);
-
-    bool hasVertices() const;
-    int calcTotalIndices();
+    //switches the vbo layout and re-uploads the active level. shared means
+    //smooth shading, per-he flat
+    void setSharedVertices(bool shared);
+    bool usesSharedVertices() const;
 
-    std::vector<uPtr<Vertex>>& getVertices();
-    std::vector<uPtr<Face>>& getFaces();
-    std::vector<uPtr<HalfEdge>>& getHes();
+    //subdivision hierarchy. subdividing keeps the coarser level cached, and
+    //if the next level up is still cached it's switched to instead
+    void subdivide();
+    void setLevel(int level);
+    int getLevel() const;
+    int numLevels() const;
+    //the active level was edited, the finer levels built from it are stale
+    void invalidateFinerLevels();
+    //the active level's vertex v moved. cage vertices carry the edit into
+    //every cached level through their stencils
+    void vertexEdited(VertexHandle v);
+    //drops every cached level, the active one becomes level 0
+    void clearLevels();
 
-    Vertex &splitEdge(HalfEdge* he1);
-
-    void triangulateFace(Face* f);
-    void catmullclarkSubdivision();
-    void extrudeFace(Face* toExtrude);
+    //the active level becomes the cage for itself and the levels subdivided from it
+    void startCage();
+    void stopCage();
 
     //added for hw7
-    void setRootJoint(uPtr<Joint> newRoot);
-    void findVertJointsRec(Vertex* v, Joint* curr, std::array<Joint*, 2>& jointArr, std::array<float, 2>& dists);
-    void skinMesh();
+    //replaces the joints with the skeleton's, in its rest pose
+    void setSkeleton(const Skeleton& skeleton);
+    //binds the active level to the skeleton's current pose, see
+    //bindNearestJoints and bindNearestBones. maxInfluences is joints per vertex
+    void skinMesh(bool toBones = false, int maxInfluences = MAX_INFLUENCES);
     bool hasJoints() const;
     Joint* getRoot() const;
+    int numJoints() const;
+    Joint* getJoint(int j) const;
+    SkeletonPose& getPose();
     bool skinned() const;
 };
 
-//hash function for a pair
-struct pair_hash {
-    template <class T1, class T2>
-    std::size_t operator () (const std::pair<T1, T2>& p) const {
-        auto h1 = std::hash<T1>{}(p.first);
-        auto h2 = std::hash<T2>{}(p.second);
-
-        return h1 ^ h2;
-    }
-};
-
-//hash function for a single object
-struct single_hash {
-    template <typename T>
-    std::size_t operator () (const T& input) const {
-        return std::hash<T>{}(input);
-    }
-};
-
 #endif // MESH_H
@@ -0,0 +1,224 @@
+#include "meshcache.h"
+#include <mappedfile.h>
+#include <parallel.h>
+#include <trace.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+const char MAGIC[8] = {'M', 'M', 'E', 'S', 'H', 0, 0, 0};
+
+//everything after the magic is a 32-bit word like the arrays
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t numVerts;
+    uint32_t numHes;
+    uint32_t numFaces;
+    uint32_t flags;
+};
+static_assert(sizeof(Header) == 32, "mesh cache header has to match the file layout");
+const size_t HEADER_WORDS = (sizeof(Header) - sizeof(MAGIC)) / 4;
+
+//every array in the file is a whole number of 32-bit words
+const uint64_t WORDS_PER_VERT = 3 + 3 + 1;
+const uint64_t WORDS_PER_HE = 4;
+const uint64_t WORDS_PER_FACE = 1 + 3;
+//joint ids (4 uint16s) and weights (4 unorm16s), only there with SKINNED
+const uint64_t WORDS_PER_SKINNED_VERT = 2 + 2;
+
+const uint32_t SKINNED = 1;
+
+bool littleEndian() {
+    uint32_t one = 1;
+    char first;
+    std::memcpy(&first, &one, 1);
+    return first == 1;
+}
+
+//reverses the bytes of each unit-sized value, 1 byte values are left alone
+void swapBytes(char* bytes, size_t size, size_t unit) {
+    for (size_t u = 0; u + unit <= size; u += unit) {
+        std::reverse(bytes + u, bytes + u + unit);
+    }
+}
+
+void swapWords(char* bytes, size_t numWords) {
+    swapBytes(bytes, 4 * numWords, 4);
+}
+
+//size of the scalars an array element is made of, which is what gets
+//swapped on big-endian hosts. everything but the packed influences is words
+template <typename T> size_t unitSize() { return 4; }
+template <> size_t unitSize<glm::u16vec4>() { return 2; }
+
+template <typename T>
+void writeArray(std::ofstream& out, const std::vector<T>& array) {
+    static_assert(sizeof(T) % 4 == 0, "mesh cache arrays are padded to 32-bit words");
+    const char* bytes = reinterpret_cast<const char*>(array.data());
+    size_t size = array.size() * sizeof(T);
+    if (littleEndian()) {
+        out.write(bytes, size);
+        return;
+    }
+    //big-endian hosts swap a block at a time on the way out
+    char block[1 << 16];
+    for (size_t done = 0; done < size; done += sizeof(block)) {
+        size_t n = std::min(sizeof(block), size - done);
+        std::memcpy(block, bytes + done, n);
+        swapBytes(block, n, unitSize<T>());
+        out.write(block, n);
+    }
+}
+
+//copies count elements out of the mapping and advances past them. big
+//copies are split across threads since this is most of the load time
+template <typename T>
+void readArray(const char*& p, std::vector<T>& array, size_t count) {
+    array.resize(count);
+    char* dst = reinterpret_cast<char*>(array.data());
+    size_t size = count * sizeof(T);
+    const char* src = p;
+    parallel::forChunks(int(count), [&](int, int begin, int end) {
+        std::memcpy(dst + begin * sizeof(T), src + begin * sizeof(T), (end - begin) * sizeof(T));
+        if (!littleEndian()) {
+            swapBytes(dst + begin * sizeof(T), (end - begin) * sizeof(T), unitSize<T>());
+        }
+    });
+    p += size;
+}
+
+//every index has to name a real element, sym and a vertex's he may also be
+//unset. a bad file is refused here instead of crashing a traversal later
+bool indicesInRange(const std::vector<uint32_t>& indices, uint32_t limit, bool allowInvalid) {
+    std::vector<char> bad(parallel::chunksFor(int(indices.size())), 0);
+    parallel::forChunks(int(indices.size()), [&](int chunk, int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            uint32_t idx = indices[i];
+            if (idx >= limit && !(allowInvalid && idx == INVALID_IDX)) {
+                bad[chunk] = 1;
+                return;
+            }
+        }
+    });
+    return std::find(bad.begin(), bad.end(), 1) == bad.end();
+}
+
+}
+
+bool MeshCache::write(const HalfEdgeMesh& mesh, const std::string& path, std::string& error) {
+    TRACE_ZONE("MeshCache::write", "io");
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        error = "could not write " + path;
+        return false;
+    }
+
+    Header header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.headerSize = sizeof(Header);
+    header.numVerts = mesh.vertPos.size();
+    header.numHes = mesh.heNext.size();
+    header.numFaces = mesh.faceHE.size();
+    header.flags = mesh.hasInfluences() ? SKINNED : 0;
+    uint32_t flags = header.flags;
+    if (!littleEndian()) {
+        swapWords(reinterpret_cast<char*>(&header) + sizeof(MAGIC), HEADER_WORDS);
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+
+    writeArray(out, mesh.vertPos);
+    writeArray(out, mesh.vertNor);
+    writeArray(out, mesh.vertHE);
+    writeArray(out, mesh.heNext);
+    writeArray(out, mesh.heSym);
+    writeArray(out, mesh.heFace);
+    writeArray(out, mesh.heVert);
+    writeArray(out, mesh.faceHE);
+    writeArray(out, mesh.faceColor);
+    if (flags & SKINNED) {
+        writeArray(out, mesh.vertJointIds);
+        writeArray(out, mesh.vertJointWeights);
+    }
+
+    if (!out) {
+        error = "could not write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool MeshCache::read(const std::string& path, HalfEdgeMesh& mesh, std::string& error) {
+    TRACE_ZONE("MeshCache::read", "io");
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        error = "could not read " + path;
+        return false;
+    }
+
+    Header header;
+    if (file.size() < sizeof(Header)) {
+        error = path + " is not a mesh cache";
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(Header));
+    if (!littleEndian()) {
+        swapWords(reinterpret_cast<char*>(&header) + sizeof(MAGIC), HEADER_WORDS);
+    }
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        error = path + " is not a mesh cache";
+        return false;
+    }
+    if (header.version != VERSION || header.headerSize != sizeof(Header)) {
+        error = path + " is mesh cache version " + std::to_string(header.version)
+                + ", expected " + std::to_string(VERSION);
+        return false;
+    }
+    bool skinned = header.flags & SKINNED;
+    if (file.size() != sizeof(Header) + 4 * ((WORDS_PER_VERT + (skinned ? WORDS_PER_SKINNED_VERT : 0)) * header.numVerts
+                                             + WORDS_PER_HE * header.numHes
+                                             + WORDS_PER_FACE * header.numFaces)) {
+        error = path + " is truncated or corrupt";
+        return false;
+    }
+
+    size_t numVerts = header.numVerts, numHes = header.numHes, numFaces = header.numFaces;
+    const char* p = file.data() + sizeof(Header);
+    readArray(p, mesh.vertPos, numVerts);
+    readArray(p, mesh.vertNor, numVerts);
+    readArray(p, mesh.vertHE, numVerts);
+    readArray(p, mesh.heNext, numHes);
+    readArray(p, mesh.heSym, numHes);
+    readArray(p, mesh.heFace, numHes);
+    readArray(p, mesh.heVert, numHes);
+    readArray(p, mesh.faceHE, numFaces);
+    readArray(p, mesh.faceColor, numFaces);
+
+    if (!indicesInRange(mesh.vertHE, numHes, true) || !indicesInRange(mesh.heNext, numHes, false)
+            || !indicesInRange(mesh.heSym, numHes, true) || !indicesInRange(mesh.heFace, numFaces, false)
+            || !indicesInRange(mesh.heVert, numVerts, false) || !indicesInRange(mesh.faceHE, numHes, false)) {
+        mesh = HalfEdgeMesh();
+        error = path + " is truncated or corrupt";
+        return false;
+    }
+
+    if (skinned) {
+        readArray(p, mesh.vertJointIds, numVerts);
+        readArray(p, mesh.vertJointWeights, numVerts);
+    } else {
+        mesh.vertJointIds.assign(numVerts, glm::u16vec4());
+        mesh.vertJointWeights.assign(numVerts, glm::u16vec4());
+    }
+    //the twin report isn't stored, every unpaired he counts as a boundary
+    mesh.boundaryEdges = std::count(mesh.heSym.begin(), mesh.heSym.end(), INVALID_IDX);
+    mesh.nonManifoldEdges = 0;
+    mesh.clearStencils();
+    mesh.topologyEdited = true;
+    mesh.editedVerts.clear();
+    mesh.editedFaces.clear();
+    return true;
+}
@@ -0,0 +1,31 @@
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#include <halfedgemesh.h>
+#include <string>
+
+//.mmesh files: a half-edge mesh saved with its connectivity already built,
+//so reopening a big asset skips the obj parse and the twin matching. the
+//file is a small header followed by the mesh's arrays exactly as they sit
+//in memory, little-endian and padded to 32-bit words:
+//
+//  header      magic "MMESH\0\0\0", version, header size, vert/he/face counts, flags
+//  per vertex  position (3 floats), normal (3 floats), half-edge
+//  per he      next, sym, face, vertex
+//  per face    half-edge, color (3 floats)
+//  per vertex  joint ids (4 uint16s), joint weights (4 unorm16s), only if skinned
+//
+//reading maps the file and copies each array out in one go. stencils and
+//subdivision levels aren't saved
+class MeshCache {
+public:
+    //bumped whenever the layout above changes once files of it are out,
+    //files of any other version are refused
+    static const uint32_t VERSION = 1;
+
+    //on failure both return false and put the reason in error
+    static bool write(const HalfEdgeMesh& mesh, const std::string& path, std::string& error);
+    static bool read(const std::string& path, HalfEdgeMesh& mesh, std::string& error);
+};
+
+#endif // MESHCACHE_H
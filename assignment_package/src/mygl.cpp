@@ -1,9 +1,15 @@
 #include "mygl.h"
 #include <la.h>
+#include <meshcache.h>
+#include <objloader.h>
+#include <parallel.h>
+#include <trace.h>
 
+#include <cfloat>
 #include <iostream>
 #include <QApplication>
 #include <QKeyEvent>
+#include <QPainter>
 
 #include <QFileDialog>
 
@@ -11,17 +17,40 @@ MyGL::MyGL(QWidget *parent)
     : OpenGLContext(parent),
       m_geomSquare(this),
       m_progLambert(this), m_progFlat(this), prog_skeleton(this), //added prog_skeleteon
+      m_progSkeletonDQ(this),
+      m_jointPalette(this),
+      m_progJoint(this), m_gizmoPalette(this), m_jointGizmo(this), m_boneLines(this),
       m_glCamera(),
-      mp_selectedVertex(nullptr),
-      mp_selectedHE(nullptr),
-      mp_selectedFace(nullptr),
+      m_selectedVertex(),
+      m_selectedHE(),
+      m_selectedFace(),
       mp_selectedJoint(nullptr),
       vd_ready(false),
       hed_ready(false),
       fd_ready(false),
-      jd_ready(false)
+      m_editCage(false),
+      m_bindToBones(false),
+      m_maxInfluences(HalfEdgeMesh::MAX_INFLUENCES),
+      m_dualQuat(false),
+      m_meshDirty(false),
+      m_pendingEdits(0),
+      m_totalEdits(0),
+      m_totalRebuilds(0),
+      m_showFrameTimes(false),
+      m_frameMs(),
+      m_frameCount(0),
+      m_skeleton(),
+      m_clip(),
+      m_clipTime(0.f),
+      m_clipTimer(this),
+      m_clipClock(),
+      m_crowdMode(false),
+      m_crowd(),
+      m_pool(parallel::numThreads())
 {
     setFocusPolicy(Qt::StrongFocus);
+    m_clipTimer.setInterval(16);
+    connect(&m_clipTimer, SIGNAL(timeout()), this, SLOT(slot_stepClip()));
 }
 
 MyGL::~MyGL()
@@ -29,6 +58,10 @@ MyGL::~MyGL()
     makeCurrent();
     glDeleteVertexArrays(1, &vao);
     m_geomSquare.destroy();
+    m_jointPalette.destroy();
+    m_gizmoPalette.destroy();
+    m_jointGizmo.destroy();
+    m_boneLines.destroy();
 }
 
 void MyGL::initializeGL()
@@ -36,6 +69,7 @@ void MyGL::initializeGL()
     // Create an OpenGL context using Qt's QOpenGLFunctions_3_2_Core class
     // If you were programming in a non-Qt context you might use GLEW (GL Extension Wrangler)instead
     initializeOpenGLFunctions();
+    trace::nameThread("gui");
     // Print out some information about the current OpenGL context
     debugContextVersion();
 
@@ -64,6 +98,13 @@ void MyGL::initializeGL()
     m_progFlat.create(":/glsl/flat.vert.glsl", ":/glsl/flat.frag.glsl");
     //adding prog skelly
     prog_skeleton.create(":glsl/skeleton.vert.glsl", ":/glsl/skeleton.frag.glsl");
+    m_progSkeletonDQ.create(":/glsl/skeleton_dq.vert.glsl", ":/glsl/skeleton.frag.glsl");
+    m_jointPalette.create();
+    m_progJoint.create(":/glsl/joint.vert.glsl", ":/glsl/flat.frag.glsl");
+    m_gizmoPalette.create();
+    //the gizmo never changes and the bones stream into buffers made here
+    m_jointGizmo.create();
+    m_boneLines.create();
 
     // We have to have a VAO bound in OpenGL 3.2 Core. But if we're not
     // using multiple VAOs, we can just bind one once.
@@ -83,6 +124,8 @@ void MyGL::resizeGL(int w, int h)
     m_progFlat.setViewProjMatrix(viewproj);
     //adding skelly for hw7
     prog_skeleton.setViewProjMatrix(viewproj);
+    m_progSkeletonDQ.setViewProjMatrix(viewproj);
+    m_progJoint.setViewProjMatrix(viewproj);
 
     printGLErrorLog();
 }
@@ -91,6 +134,10 @@ void MyGL::resizeGL(int w, int h)
 //For example, when the function update() is called, paintGL is called implicitly.
 void MyGL::paintGL()
 {
+    TRACE_ZONE("paintGL", "frame");
+    int64_t frameStart = trace::now();
+    flushMeshEdits();
+
     // Clear the screen so that we only see newly drawn images
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -103,6 +150,10 @@ void MyGL::paintGL()
     prog_skeleton.setViewProjMatrix(m_glCamera.getViewProj());
     prog_skeleton.setCamPos(m_glCamera.eye);
     prog_skeleton.setModelMatrix(glm::mat4());
+    m_progSkeletonDQ.setViewProjMatrix(m_glCamera.getViewProj());
+    m_progSkeletonDQ.setCamPos(m_glCamera.eye);
+    m_progSkeletonDQ.setModelMatrix(glm::mat4());
+    m_progJoint.setViewProjMatrix(m_glCamera.getViewProj());
 
     if (mesh.hasVertices() && !mesh.skinned()) {
         glm::mat4 model = glm::mat4();
@@ -113,40 +164,42 @@ void MyGL::paintGL()
     }
 
     if (mesh.hasJoints()) {
-        int mCount = 0;
-        std::array<glm::mat4, 100> binds, transforms;
-        m_progFlat.setModelMatrix(glm::mat4());
+        TRACE_ZONE("drawJoints", "frame");
+        //one pass over the flat pose brings every edited joint up to date
+        SkeletonPose& pose = mesh.getPose();
+        pose.update();
 
-        std::vector<Joint*> queue, toDraw;
-        queue.push_back(mesh.getRoot());
-        //data structures moment -- do while for level order traversal
-        do {
-            //get joint and draw it
-            Joint* curr = queue[0];
-            curr->create();
-            toDraw.push_back(curr);
-
-            //update binds and transforms mat for prog skelly
-            binds[curr->getId() - 1] = curr->getBind();
-            transforms[curr->getId() - 1] = curr->getOverallTransformation();
-            mCount++;
-
-            //add children to queue
-            for (uPtr<Joint>& child : curr->getChildren()) {
-                queue.push_back(child.get());
-            }
-            queue.erase(queue.begin());
-        } while (!queue.empty());
+        m_progFlat.setModelMatrix(glm::mat4());
 
         if (mesh.skinned()) {
-            prog_skeleton.setBinds(binds, mCount);
-            prog_skeleton.setTransforms(transforms, mCount);
-            prog_skeleton.draw(mesh);
+            //every skinned mesh adds its skeleton before the one upload
+            m_jointPalette.clear(m_dualQuat ? JointPalette::DUAL_QUATERNIONS : JointPalette::MATRICES);
+            ShaderProgram& prog = m_dualQuat ? m_progSkeletonDQ : prog_skeleton;
+            if (m_crowd.numInstances() > 0) {
+                int jointOffset = m_jointPalette.addSkinTransforms(m_crowd.getPalette());
+                m_jointPalette.upload();
+                prog.setJointPalette(m_jointPalette, jointOffset, m_crowd.numJoints());
+                prog.draw(mesh, m_crowd.numInstances());
+            } else {
+                int jointOffset = m_jointPalette.add(pose.getWorldTransforms(), pose.getBindTransforms());
+                m_jointPalette.upload();
+                prog.setJointPalette(m_jointPalette, jointOffset);
+                prog.draw(mesh);
+            }
         }
 
+        //every gizmo in one instanced draw and every bone in one more
+        m_gizmoPalette.clear();
+        int gizmoOffset = m_gizmoPalette.addSkinTransforms(pose.getWorldTransforms());
+        m_gizmoPalette.upload();
+        m_progJoint.setJointPalette(m_gizmoPalette, gizmoOffset);
+        m_progJoint.setSelectedJoint(mp_selectedJoint ? mp_selectedJoint->getId() : -1);
+        m_boneLines.update(pose);
+
         glDisable(GL_DEPTH_TEST);
-        for (Joint* j : toDraw) {
-            m_progFlat.draw(*j);
+        m_progJoint.draw(m_jointGizmo, mesh.numJoints());
+        if (m_boneLines.elemCount() > 0) {
+            m_progFlat.draw(m_boneLines);
         }
         glEnable(GL_DEPTH_TEST);
     }
@@ -181,15 +234,72 @@ void MyGL::paintGL()
         glEnable(GL_DEPTH_TEST);
     }
 
-    if (jd_ready) {
-        glDisable(GL_DEPTH_TEST);
-        mp_selectedJoint->create();
-        m_progFlat.setModelMatrix(glm::mat4());
-        m_progFlat.draw(*mp_selectedJoint);
-        glEnable(GL_DEPTH_TEST);
+    //buffers given back this frame wait for reuse up to the budget
+    BufferPool& pool = getBufferPool();
+    pool.trim(POOLED_BYTES);
+    trace::counter("gpuBytesInUse", pool.bytesInUse());
+    trace::counter("gpuBytesPooled", pool.bytesFree());
+
+    //the overlay itself isn't part of the frame it reports
+    float frameMs = (trace::now() - frameStart) * 1e-6f;
+    m_frameMs[m_frameCount % FRAME_HISTORY] = frameMs;
+    m_frameCount++;
+    trace::counter("frameMs", frameMs);
+    if (m_showFrameTimes) {
+        drawFrameTimes();
     }
 }
 
+void MyGL::drawFrameTimes() {
+    int numFrames = std::min(m_frameCount, FRAME_HISTORY);
+    float sum = 0.f, worst = 0.f;
+    for (int i = 0; i < numFrames; i++) {
+        sum += m_frameMs[i];
+        worst = std::max(worst, m_frameMs[i]);
+    }
+    float last = m_frameMs[(m_frameCount - 1) % FRAME_HISTORY];
+
+    //one bar per frame, oldest on the left. the graph tops out at 33ms with
+    //a line at 16.7ms, the budget for 60 fps
+    const int barW = 2, graphH = 60, left = 8, top = 8;
+    const float maxMs = 33.3f;
+    QPainter painter(this);
+    painter.fillRect(left, top, FRAME_HISTORY * barW + 8, graphH + 76, QColor(0, 0, 0, 150));
+    for (int i = 0; i < numFrames; i++) {
+        float ms = m_frameMs[(m_frameCount - numFrames + i) % FRAME_HISTORY];
+        int h = std::max(1, int(std::min(ms, maxMs) / maxMs * graphH));
+        painter.fillRect(left + 4 + i * barW, top + 4 + graphH - h, barW, h,
+                         ms > 16.7f ? QColor(230, 70, 50) : QColor(90, 200, 90));
+    }
+    int budget = top + 4 + graphH - int(16.7f / maxMs * graphH);
+    painter.setPen(QColor(255, 255, 255, 120));
+    painter.drawLine(left + 4, budget, left + 4 + FRAME_HISTORY * barW, budget);
+
+    painter.setPen(Qt::white);
+    painter.drawText(left + 4, top + graphH + 20, QString("paintGL %1 ms  avg %2  max %3")
+                     .arg(last, 0, 'f', 2).arg(sum / numFrames, 0, 'f', 2).arg(worst, 0, 'f', 2));
+
+    //what's holding gpu memory, so a leak shows up as a number that climbs
+    auto mb = [](GLsizeiptr bytes) { return QString::number(bytes / 1048576.0, 'f', 2); };
+    BufferPool& pool = getBufferPool();
+    painter.drawText(left + 4, top + graphH + 36, QString("gpu %1 MB in %2 buffers  pooled %3 MB")
+                     .arg(mb(pool.bytesInUse())).arg(pool.buffersInUse()).arg(mb(pool.bytesFree())));
+    GLsizeiptr skeletonBytes = m_jointGizmo.gpuBytes() + m_boneLines.gpuBytes() + m_gizmoPalette.gpuBytes();
+    GLsizeiptr selectionBytes = m_vertDisplay.gpuBytes() + m_heDisplay.gpuBytes() + m_fDisplay.gpuBytes();
+    painter.drawText(left + 4, top + graphH + 52, QString("mesh %1  skin %2  joints %3  selection %4")
+                     .arg(mb(mesh.gpuBytes())).arg(mb(m_jointPalette.gpuBytes()))
+                     .arg(mb(skeletonBytes)).arg(mb(selectionBytes)));
+    if (trace::recording()) {
+        painter.drawText(left + 4, top + graphH + 68, QString("recording trace, %1 events").arg(trace::numEvents()));
+    }
+    painter.end();
+
+    //qpainter leaves its own gl state behind
+    glBindVertexArray(vao);
+    glEnable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+}
+
 
 void MyGL::keyPressEvent(QKeyEvent *e)
 {
@@ -238,13 +348,13 @@ void MyGL::keyPressEvent(QKeyEvent *e)
         hed_ready = false;
         fd_ready = true;
         this->m_fDisplay.updateFace(m_heDisplay.getFace());
-        slot_setSelectedFace(m_heDisplay.getFace());
+        selectFace(m_heDisplay.getFace());
     } else if (e->key() == Qt::Key_V) {
         if (hed_ready) {
             hed_ready = false;
             vd_ready = true;
             this->m_vertDisplay.updateVertex(m_heDisplay.getVertex());
-            slot_setSelectedVertex(m_heDisplay.getVertex());
+            selectVertex(m_heDisplay.getVertex());
         }
     } else if (e->key() == Qt::Key_H) {
         bool skip = false;
@@ -255,14 +365,15 @@ void MyGL::keyPressEvent(QKeyEvent *e)
             fd_ready = false;
             hed_ready = true;
             this->m_heDisplay.updateHE(m_fDisplay.getHE());
-            slot_setSelectedHE(m_fDisplay.getHE());
+            selectHE(m_fDisplay.getHE());
             skip = true;
         }
-        if (!skip && vd_ready) {
+        //a loose vertex has no he to go to
+        if (!skip && vd_ready && m_vertDisplay.getHE().isValid()) {
             hed_ready = true;
             vd_ready = false;
             this->m_heDisplay.updateHE(m_vertDisplay.getHE());
-            slot_setSelectedHE(m_vertDisplay.getHE());
+            selectHE(m_vertDisplay.getHE());
         }
     }
     m_glCamera.RecomputeAttributes();
@@ -270,125 +381,132 @@ void MyGL::keyPressEvent(QKeyEvent *e)
 }
 
 Mesh MyGL::readMesh(QFile file) {
-    //https://forum.qt.io/topic/59249/read-textfile-and-display-on-qlabel-solved
-    //help log 6:30 10/11
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        std::cout << "could not read" << std::endl;
-        return Mesh();
-    }
-    QString string;
-    QTextStream in(&file);
-    QTextStream stream(&file);
-
-    //get rid of header data
-    for (int i = 0; i < 4; i++) {
-        stream.readLine();
+    TRACE_ZONE("readMesh", "io");
+    //prebuilt meshes come back as they were saved, no parsing or twin matching
+    if (file.fileName().endsWith(".mmesh")) {
+        Mesh cached(this);
+        std::string error;
+        if (!MeshCache::read(file.fileName().toStdString(), cached, error)) {
+            std::cout << error << std::endl;
+        }
+        return cached;
     }
 
-    //vcetors to contain data that is read in
-    std::vector<glm::vec3> vertices;
-    std::vector<glm::vec3> normals;
-    std::vector<std::vector<int>> faces;
-
-    while (!stream.atEnd()){
-        string = stream.readLine();
-
-        if (string.length() < 2) continue;
-
-        if (string[0] == 'v' && string[1] == ' ') {
-            //line is a vertex
-            std::string temp = string.toStdString().substr(2); //skip the "v " prefix
-            std::stringstream ss(temp);
-            std::vector<float> v;
-            float value;
-
-            while (ss >> value) {
-                v.push_back(value);
-            }
-            vertices.push_back(glm::vec3(v[0], v[1], v[2]));
-        } else if (string[0] == 'v' && string[1] == 'n') {
-            //line is a normal
-            std::string temp = string.toStdString().substr(3); //skip the "vn " prefix
-            std::stringstream ss(temp);
-            std::vector<float> v;
-            float value;
-
-            while (ss >> value) {
-                v.push_back(value);
-            }
-            normals.push_back(glm::vec3(v[0], v[1], v[2]));
-        } else if (string[0] == 'f') {
-            //line is a face
-            std::string temp = string.toStdString().substr(2); //skip the "f " prefix
-            std::stringstream ss(temp);
-            std::vector<int> vertexIndices;
-            std::string s;
-            int num1, num2, num3;
-            char slash1, slash2;
-            //man i love string steams :)
-            while (ss >> num1 >> slash1 >> num2 >> slash2 >> num3) {
-                //subtract 1 because obj isn't 0 indexed
-                vertexIndices.push_back(num1 - 1);
-            }
-
-            faces.push_back(vertexIndices);
-        }
+    ObjData obj;
+    std::string error;
+    if (!loadOBJ(file.fileName().toStdString(), obj, error)) {
+        std::cout << error << std::endl;
+        return Mesh(this);
     }
 
     //use mesh constructor to turn this data into a mesh
-    Mesh mesh = Mesh(this, vertices, normals, faces);
-
-    file.close();
-
-    return mesh;
+    Mesh m(this, obj.positions, obj.normals, obj.faceOffsets, obj.faceIndices);
+    if (m.numNonManifoldEdges() > 0) {
+        std::cout << m.numNonManifoldEdges() << " non-manifold edges, "
+                  << m.numBoundaryEdges() << " boundary edges" << std::endl;
+    }
+    return m;
 }
 
 void MyGL::slot_loadOBJ() {
     QString fileName = QFileDialog::getOpenFileName(this,
-                                            tr("Open OBJ"), "/home/", tr("OBJ Files (*.obj)"));
+                                            tr("Open OBJ"), "/home/", tr("Meshes (*.obj *.mmesh)"));
 
+    TRACE_ZONE("loadMesh", "ui");
+    bool shared = mesh.usesSharedVertices();
+    mesh.clearLevels();
     mesh = readMesh(QFile(fileName));
+    mesh.setSharedVertices(shared);
+    //the old mesh took its skeleton with it, so everything posing it goes too
+    mp_selectedJoint = nullptr;
+    m_clip = AnimationClip();
+    m_skeleton = Skeleton();
+    m_crowd.clear();
+    if (m_editCage) {
+        mesh.startCage();
+    }
 
     mesh.create();
+    m_meshDirty = false;
+    m_pendingEdits = m_totalEdits = m_totalRebuilds = 0;
+    emit sig_sendEditStats(0, 0);
 
-    std::vector<QListWidgetItem*> listItems;
-    for (uPtr<Face>& fPtr : mesh.getFaces()) {
-        listItems.push_back(fPtr.get());
-    }
-    emit sig_sendFaceItems(listItems);
+    clearSelection();
+    sendElementCounts(true);
+    emit sig_sendLevels(mesh.numLevels(), mesh.getLevel());
+}
 
-    listItems.clear();
-    for (uPtr<Vertex>& vPtr : mesh.getVertices()) {
-        listItems.push_back(vPtr.get());
+void MyGL::slot_saveMesh() {
+    QString fileName = QFileDialog::getSaveFileName(this,
+                                            tr("Save Mesh"), "/home/", tr("Mesh Cache (*.mmesh)"));
+    if (fileName.isEmpty()) {
+        return;
+    }
+    if (!fileName.endsWith(".mmesh")) {
+        fileName += ".mmesh";
     }
-    emit sig_sendVertexItems(listItems);
 
-    listItems.clear();
-    for (uPtr<HalfEdge>& hePtr : mesh.getHes()) {
-        listItems.push_back(hePtr.get());
+    std::string error;
+    if (!MeshCache::write(mesh, fileName.toStdString(), error)) {
+        std::cout << error << std::endl;
     }
-    emit sig_sendHeItems(listItems);
 }
 
-void MyGL::slot_setSelectedVertex(QListWidgetItem *i) {
-    mp_selectedVertex = static_cast<Vertex*>(i);
-    m_vertDisplay = VertexDisplay(this, mp_selectedVertex);
+void MyGL::sendElementCounts(bool newMesh) {
+    //the lists resize right away, so this covers repopulating them too
+    TRACE_ZONE("sendElementCounts", "ui");
+    emit sig_sendElementCounts(mesh.numVertices(), mesh.numHes(), mesh.numFaces(), newMesh);
+}
+
+void MyGL::levelChanged() {
+    //handles from another level mean nothing on this one
+    clearSelection();
+    sendElementCounts(true);
+    emit sig_sendLevels(mesh.numLevels(), mesh.getLevel());
+    update();
+}
+
+void MyGL::clearSelection() {
+    m_selectedVertex = VertexHandle();
+    m_selectedHE = HalfEdgeHandle();
+    m_selectedFace = FaceHandle();
+    vd_ready = false;
+    hed_ready = false;
+    fd_ready = false;
+}
+
+//list rows are in element order, so the row is the element's index
+void MyGL::slot_setSelectedVertex(const QModelIndex &i) {
+    selectVertex(VertexHandle(i.row()));
+}
+
+void MyGL::slot_setSelectedHE(const QModelIndex &i) {
+    selectHE(HalfEdgeHandle(i.row()));
+}
+
+void MyGL::slot_setSelectedFace(const QModelIndex &i) {
+    selectFace(FaceHandle(i.row()));
+}
+
+void MyGL::selectVertex(VertexHandle v) {
+    m_selectedVertex = v;
+    m_vertDisplay = VertexDisplay(this, &mesh, m_selectedVertex);
     vd_ready = true;
 
     update();
 }
 
-void MyGL::slot_setSelectedHE(QListWidgetItem *i) {
-    mp_selectedHE = static_cast<HalfEdge*>(i);
-    m_heDisplay = HalfEdgeDisplay(this, mp_selectedHE);
+void MyGL::selectHE(HalfEdgeHandle he) {
+    m_selectedHE = he;
+    m_heDisplay = HalfEdgeDisplay(this, &mesh, m_selectedHE);
     hed_ready = true;
 
     update();
 }
 
-void MyGL::slot_setSelectedFace(QListWidgetItem *i) {
-    mp_selectedFace = static_cast<Face*>(i);
-    m_fDisplay = FaceDisplay(this, mp_selectedFace);
+void MyGL::selectFace(FaceHandle f) {
+    m_selectedFace = f;
+    m_fDisplay = FaceDisplay(this, &mesh, m_selectedFace);
     fd_ready = true;
 
     update();
@@ -398,8 +516,8 @@ void MyGL::slot_splitEdge() {
     if (!hed_ready) {
         return;
     }
-    HalfEdge* toSplit = mp_selectedHE;
-    mesh.splitEdge(toSplit);
+    mesh.splitEdge(m_selectedHE);
+    mesh.invalidateFinerLevels();
     updateMesh();
 }
 
@@ -407,8 +525,8 @@ void MyGL::slot_triangulateFace() {
     if (!fd_ready) {
         return;
     }
-    Face* toTriangulate = mp_selectedFace;
-    mesh.triangulateFace(toTriangulate);
+    mesh.triangulateFace(m_selectedFace);
+    mesh.invalidateFinerLevels();
     updateMesh();
 }
 
@@ -416,7 +534,8 @@ void MyGL::slot_newX(double x) {
     if (!vd_ready) {
         return;
     }
-    mp_selectedVertex->setX(float(x));
+    mesh.setX(m_selectedVertex, float(x));
+    mesh.vertexEdited(m_selectedVertex);
     updateMesh();
 }
 
@@ -424,7 +543,8 @@ void MyGL::slot_newY(double y) {
     if (!vd_ready) {
         return;
     }
-    mp_selectedVertex->setY(float(y));
+    mesh.setY(m_selectedVertex, float(y));
+    mesh.vertexEdited(m_selectedVertex);
     updateMesh();
 }
 
@@ -432,7 +552,8 @@ void MyGL::slot_newZ(double z) {
     if (!vd_ready) {
         return;
     }
-    mp_selectedVertex->setZ(float(z));
+    mesh.setZ(m_selectedVertex, float(z));
+    mesh.vertexEdited(m_selectedVertex);
     updateMesh();
 }
 
@@ -440,7 +561,8 @@ void MyGL::slot_newR(double r) {
     if (!fd_ready) {
         return;
     }
-    mp_selectedFace->setR(float(r));
+    mesh.setR(m_selectedFace, float(r));
+    mesh.invalidateFinerLevels();
     updateMesh();
 }
 
@@ -448,7 +570,8 @@ void MyGL::slot_newG(double g) {
     if (!fd_ready) {
         return;
     }
-    mp_selectedFace->setG(float(g));
+    mesh.setG(m_selectedFace, float(g));
+    mesh.invalidateFinerLevels();
     updateMesh();
 }
 
@@ -456,99 +579,238 @@ void MyGL::slot_newB(double b) {
     if (!fd_ready) {
         return;
     }
-    mp_selectedFace->setB(float(b));
+    mesh.setB(m_selectedFace, float(b));
+    mesh.invalidateFinerLevels();
     updateMesh();
 }
 
 void MyGL::updateMesh() {
-    if (mesh.hasVertices()) mesh.create();
+    //a held spin box fires many of these per frame, they all land in the
+    //mesh's edit log and get uploaded together
+    m_meshDirty = true;
+    m_pendingEdits++;
+    update();
+}
 
-    std::vector<QListWidgetItem*> listItems;
-    for (uPtr<Face>& fPtr : mesh.getFaces()) {
-        listItems.push_back(fPtr.get());
+void MyGL::flushMeshEdits() {
+    if (!m_meshDirty) {
+        return;
     }
-    emit sig_sendFaceItems(listItems);
-
-    listItems.clear();
-    for (uPtr<Vertex>& vPtr : mesh.getVertices()) {
-        listItems.push_back(vPtr.get());
+    //topology edits drop the cage, the edited mesh becomes the new one
+    if (m_editCage && !mesh.hasStencils()) {
+        mesh.startCage();
     }
-    emit sig_sendVertexItems(listItems);
-
-    listItems.clear();
-    for (uPtr<HalfEdge>& hePtr : mesh.getHes()) {
-        listItems.push_back(hePtr.get());
+    trace::counter("pendingEdits", m_pendingEdits);
+    //only connectivity changes the lists' lengths
+    bool topologyEdited = mesh.hasTopologyEdits();
+    bool rebuilt = mesh.hasVertices() && mesh.updateBuffers();
+    if (topologyEdited) {
+        sendElementCounts(false);
     }
-    emit sig_sendHeItems(listItems);
 
-    update();
+    //frames whose edits left nothing to upload aren't rebuilds
+    m_totalEdits += m_pendingEdits;
+    if (rebuilt) {
+        m_totalRebuilds++;
+    }
+    emit sig_sendEditStats(m_totalEdits, m_totalRebuilds);
+    m_pendingEdits = 0;
+    m_meshDirty = false;
 }
 
 void MyGL::slot_subdivide() {
-    this->mesh.catmullclarkSubdivision();
-    updateMesh();
+    if (!mesh.hasVertices()) {
+        return;
+    }
+    TRACE_ZONE("subdivide", "ui");
+    this->mesh.subdivide();
+    levelChanged();
+}
+
+void MyGL::slot_setLevel(int level) {
+    mesh.setLevel(level);
+    levelChanged();
 }
 
 void MyGL::slot_extrude() {
     if (!fd_ready) {
         return;
     }
-    Face* toExtrude = mp_selectedFace;
-    mesh.extrudeFace(toExtrude);
+    mesh.extrudeFace(m_selectedFace);
+    mesh.invalidateFinerLevels();
     updateMesh();
 }
 
+void MyGL::slot_setEditCage(bool editCage) {
+    m_editCage = editCage;
+    if (editCage) {
+        mesh.startCage();
+    } else {
+        mesh.stopCage();
+    }
+    //starting a cage drops the finer levels
+    emit sig_sendLevels(mesh.numLevels(), mesh.getLevel());
+}
+
+void MyGL::slot_setSharedVertices(bool shared) {
+    mesh.setSharedVertices(shared);
+    update();
+}
+
+void MyGL::slot_setShowFrameTimes(bool show) {
+    m_showFrameTimes = show;
+    update();
+}
+
+void MyGL::slot_setRecordTrace(bool record) {
+    if (record) {
+        trace::start();
+        update();
+        return;
+    }
+
+    trace::stop();
+    QString fileName = QFileDialog::getSaveFileName(this,
+                                            tr("Save Trace"), "/home/", tr("Chrome Trace (*.json)"));
+    if (fileName.isEmpty()) {
+        return;
+    }
+    if (!fileName.endsWith(".json")) {
+        fileName += ".json";
+    }
+
+    std::string error;
+    if (!trace::writeChromeJSON(fileName.toStdString(), error)) {
+        std::cout << error << std::endl;
+        return;
+    }
+    std::cout << "wrote " << trace::numEvents() << " trace events to " << fileName.toStdString();
+    if (trace::numDropped() > 0) {
+        std::cout << ", " << trace::numDropped() << " dropped";
+    }
+    std::cout << std::endl;
+    update();
+}
+
 void MyGL::slot_loadJSON() {
     QString fileName = QFileDialog::getOpenFileName(this,
                                                     tr("Open OBJ"), "/home/", tr("JSON Files (*.json)"));
 
-    uPtr<Joint> root = readJoints(QFile(fileName));
-    emit sig_sendRootNode(root.get());
-    mesh.setRootJoint(std::move(root));
+    Skeleton skeleton;
+    std::string error;
+    if (!loadSkeletonJSON(fileName.toStdString(), skeleton, error)) {
+        std::cout << error << std::endl;
+        return;
+    }
+
+    //the selected joint and the clip go away with the old skeleton
+    mp_selectedJoint = nullptr;
+    m_clip = AnimationClip();
+    m_skeleton = skeleton;
+    m_crowd.clear();
+    mesh.setSkeleton(skeleton);
+    emit sig_sendRootNode(mesh.getRoot());
+    //a skinned mesh was just unbound and has to be drawn in its rest shape
+    updateMesh();
 }
 
-uPtr<Joint> MyGL::readJoints(QFile file) {
-    //https://stackoverflow.com/questions/15893040/how-to-create-read-write-json-files-in-qt5
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        std::cout << "could not read" << std::endl;
-        return nullptr;
+void MyGL::slot_loadClip() {
+    if (!mesh.hasJoints()) {
+        std::cout << "load a skeleton before its animation" << std::endl;
+        return;
+    }
+    QString fileName = QFileDialog::getOpenFileName(this,
+                                                    tr("Open Clip"), "/home/", tr("JSON Files (*.json)"));
+    if (fileName.isEmpty()) {
+        return;
     }
-    QString string = file.readAll();
-    file.close();
-    QJsonDocument json = QJsonDocument::fromJson(string.toUtf8());
-    QJsonObject object = json.object();
-    QJsonObject rootJoint = object["root"].toObject();
-    return readJointsRec(rootJoint, nullptr);
-}
 
-uPtr<Joint> MyGL::readJointsRec(QJsonObject joint, Joint* parent) {
-    QJsonArray currPos = joint["pos"].toArray(), currRot = joint["rot"].toArray(), currChildren = joint["children"].toArray();
+    AnimationClip clip;
+    std::string error;
+    if (!loadAnimationJSON(fileName.toStdString(), m_skeleton, clip, error)) {
+        std::cout << error << std::endl;
+        return;
+    }
+    m_clip = std::move(clip);
+    m_clipTime = 0.f;
+    m_clip.evaluate(m_clipTime, mesh.getPose());
+    resetCrowd();
+    update();
+}
 
-    QString name = joint["name"].toString();
+void MyGL::slot_setPlayClip(bool play) {
+    if (play) {
+        m_clipClock.start();
+        m_clipTimer.start();
+    } else {
+        m_clipTimer.stop();
+    }
+}
 
-    glm::vec3 position = glm::vec3(currPos[0].toDouble(), currPos[1].toDouble(), currPos[2].toDouble());
-    glm::vec3 axis = glm::vec3(currRot[1].toDouble(), currRot[2].toDouble(), currRot[3].toDouble());
-    glm::quat rotation = glm::quat(glm::angleAxis(float(currRot[0].toDouble()), axis));
+void MyGL::slot_stepClip() {
+    float dt = m_clipClock.restart() * 0.001f;
+    if (m_crowd.numInstances() > 0) {
+        m_crowd.update(dt, m_pool);
+    }
+    //a clip for an older skeleton was dropped when the new one loaded
+    if (!m_clip.isEmpty() && m_clip.numJoints() == mesh.numJoints()) {
+        m_clipTime += dt;
+        if (m_clip.duration > 0.f) {
+            m_clipTime = std::fmod(m_clipTime, m_clip.duration);
+        }
+        m_clip.evaluate(m_clipTime, mesh.getPose());
+    }
+    update();
+}
 
-    uPtr<Joint> curr = mkU<Joint>(this, name, position, rotation);
-    curr->setText(0, QString::number(curr->getId()) + ": " + name);
+void MyGL::slot_setCrowd(bool crowd) {
+    m_crowdMode = crowd;
+    resetCrowd();
+    update();
+}
 
-    for (int i = 0; i < currChildren.size(); i++) {
-        readJointsRec(currChildren[i].toObject(), curr.get());
+void MyGL::resetCrowd() {
+    m_crowd.clear();
+    if (!m_crowdMode) {
+        return;
+    }
+    if (!mesh.skinned() || !mesh.hasJoints()) {
+        std::cout << "crowd mode needs a skinned mesh" << std::endl;
+        return;
     }
 
-    if (parent != nullptr) {
-        curr->setParent(parent);
-        parent->addChild(std::move(curr));
-        return NULL;
-    } else {
-        return curr;
+    //space the instances by the mesh's footprint so they don't overlap
+    glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+    for (int v = 0; v < mesh.numVertices(); v++) {
+        lo = glm::min(lo, mesh.getPos(VertexHandle(v)));
+        hi = glm::max(hi, mesh.getPos(VertexHandle(v)));
     }
+    float spacing = 1.25f * std::max(hi.x - lo.x, hi.z - lo.z);
+
+    m_crowd.setSkeleton(m_skeleton, mesh.getPose().getBindTransforms());
+    m_crowd.setClip(m_clip.numJoints() == m_crowd.numJoints() && !m_clip.isEmpty() ? &m_clip : nullptr);
+    m_crowd.scatter(CROWD_SIZE, spacing);
+    m_crowd.update(0.f, m_pool);
 }
 
 void MyGL::slot_skinMesh() {
-    mesh.skinMesh();
+    mesh.skinMesh(m_bindToBones, m_maxInfluences);
+    resetCrowd();
     updateMesh();
+    emit sig_sendLevels(mesh.numLevels(), mesh.getLevel());
+}
+
+void MyGL::slot_setBindToBones(bool toBones) {
+    m_bindToBones = toBones;
+}
+
+void MyGL::slot_setMaxInfluences(int count) {
+    m_maxInfluences = count;
+}
+
+void MyGL::slot_setDualQuat(bool dualQuat) {
+    m_dualQuat = dualQuat;
+    update();
 }
 
 void MyGL::slot_setSelectedJoint(QTreeWidgetItem* item, int column) {
@@ -557,7 +819,6 @@ void MyGL::slot_setSelectedJoint(QTreeWidgetItem* item, int column) {
     }
     mp_selectedJoint = static_cast<Joint*>(item);
     mp_selectedJoint->select();
-    jd_ready = true;
 
     this->makeJointTransformString();
 
@@ -566,55 +827,55 @@ void MyGL::slot_setSelectedJoint(QTreeWidgetItem* item, int column) {
 
 void MyGL::slot_posXRot() {
     mp_selectedJoint->posXRot();
-    updateMesh();
+    update();
     this->makeJointTransformString();
 }
 
 void MyGL::slot_posYRot() {
     mp_selectedJoint->posYRot();
-    updateMesh();
+    update();
     this->makeJointTransformString();
 }
 
 void MyGL::slot_posZRot() {
     mp_selectedJoint->posZRot();
-    updateMesh();
+    update();
     this->makeJointTransformString();
 }
 
 void MyGL::slot_negXRot() {
     mp_selectedJoint->negXRot();
-    updateMesh();
+    update();
     this->makeJointTransformString();
 }
 
 void MyGL::slot_negYRot() {
     mp_selectedJoint->negYRot();
-    updateMesh();
+    update();
     this->makeJointTransformString();
 }
 
 void MyGL::slot_negZRot() {
     mp_selectedJoint->negZRot();
-    updateMesh();
+    update();
     this->makeJointTransformString();
 }
 
 void MyGL::slot_newJointX(double x) {
     mp_selectedJoint->setX(x);
-    updateMesh();
+    update();
     this->makeJointTransformString();
 }
 
 void MyGL::slot_newJointY(double y) {
     mp_selectedJoint->setY(y);
-    updateMesh();
+    update();
     this->makeJointTransformString();
 }
 
 void MyGL::slot_newJointZ(double z) {
     mp_selectedJoint->setZ(z);
-    updateMesh();
+    update();
     this->makeJointTransformString();
 }
 
@@ -11,13 +11,16 @@
 #include <QOpenGLShaderProgram>
 
 #include <mesh.h>
+#include <animation.h>
+#include <crowd.h>
+#include <threadpool.h>
 #include <QFile>
+#include <QTimer>
+#include <QElapsedTimer>
 #include "drawablecomponent.h"
 
 #include "joint.h"
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
+#include <QModelIndex>
 
 class MyGL
     : public OpenGLContext
@@ -28,6 +31,12 @@ private:
     ShaderProgram m_progLambert;// A shader program that uses lambertian reflection
     ShaderProgram m_progFlat;// A shader program that uses "flat" reflection (no shadowing at all)
     ShaderProgram prog_skeleton; //added for hw7
+    ShaderProgram m_progSkeletonDQ; //prog_skeleton with dual quaternion skinning
+    JointPalette m_jointPalette; //every skinned mesh's joint matrices for this frame
+    ShaderProgram m_progJoint; //instanced joint gizmos
+    JointPalette m_gizmoPalette; //the joints' world matrices m_progJoint places gizmos with
+    JointGizmo m_jointGizmo;
+    BoneLines m_boneLines;
 
     GLuint vao; // A handle for our vertex array object. This will store the VBOs created in our geometry classes.
                 // Don't worry too much about this. Just know it is necessary in order to render geometry.
@@ -36,18 +45,72 @@ private:
 
     Mesh mesh; // mesh added that will be populated through the file dialogue handler
 
-    Vertex *mp_selectedVertex;
-    HalfEdge *mp_selectedHE;
-    Face *mp_selectedFace;
+    VertexHandle m_selectedVertex;
+    HalfEdgeHandle m_selectedHE;
+    FaceHandle m_selectedFace;
     Joint *mp_selectedJoint;
 
     bool vd_ready; //vertex display ready
     bool hed_ready; //half edge display ready
     bool fd_ready; //face display ready
-    bool jd_ready; //joint display ready
+
+    bool m_editCage; //keep the mesh's cage editable through subdivision
+    bool m_bindToBones; //skin to the nearest bones instead of the nearest joints
+    int m_maxInfluences; //joints per vertex when skinning
+    bool m_dualQuat; //draw skinned meshes with m_progSkeletonDQ
+
+    //edit coalescing. updateMesh() only queues, the next paintGL pushes
+    //everything queued since the last frame to the vbos in one go
+    bool m_meshDirty;
+    int m_pendingEdits;  //edits queued for the next frame
+    int m_totalEdits;    //edits since the mesh was loaded
+    int m_totalRebuilds; //frames that actually touched the vbos
+
+    //frame time overlay. cpu time spent in paintGL for the last
+    //FRAME_HISTORY frames, the gpu work it queues isn't waited on
+    static const int FRAME_HISTORY = 120;
+    bool m_showFrameTimes;
+    std::array<float, FRAME_HISTORY> m_frameMs;
+    int m_frameCount;
+
+    //free buffers the pool keeps for reuse between frames, the rest are
+    //deleted at the end of each one
+    static const GLsizeiptr POOLED_BYTES = 32 << 20;
+
+    //animation playback. the skeleton is kept to match clips' tracks to
+    //joints by name, the timer ticks the clip forward by wall clock time
+    Skeleton m_skeleton;
+    AnimationClip m_clip;
+    float m_clipTime; //seconds into m_clip
+    QTimer m_clipTimer;
+    QElapsedTimer m_clipClock;
+
+    //crowd mode draws CROWD_SIZE copies of the skinned mesh in one
+    //instanced call, each posed by m_crowd on m_pool
+    static const int CROWD_SIZE = 256;
+    bool m_crowdMode;
+    Crowd m_crowd;
+    ThreadPool m_pool;
+    //lays the crowd out again for the current skeleton, binds and clip
+    void resetCrowd();
 
     void makeJointTransformString();
 
+    //shared by the list widget slots and the keyboard traversal
+    void selectVertex(VertexHandle v);
+    void selectHE(HalfEdgeHandle he);
+    void selectFace(FaceHandle f);
+
+    //tells the main window's element lists how many rows they have
+    void sendElementCounts(bool newMesh);
+    //refreshes the ui after the mesh switched subdivision levels
+    void levelChanged();
+    void clearSelection();
+    //applies the queued edits, called once per frame from paintGL
+    void flushMeshEdits();
+    //paints the frame time graph over the finished frame
+    void drawFrameTimes();
+
 public:
     explicit MyGL(QWidget *parent = nullptr);
     ~MyGL();
@@ -61,20 +124,18 @@ public:
     VertexDisplay m_vertDisplay;
     HalfEdgeDisplay m_heDisplay;
     FaceDisplay m_fDisplay;
-    Joint m_jointDisplay;
 
+    //queues a vbo update for the next frame
     void updateMesh();
 
-    uPtr<Joint> readJoints(QFile file);
-    uPtr<Joint> readJointsRec(QJsonObject joint, Joint* parent);
-
 protected:
     void keyPressEvent(QKeyEvent *e);
 
 signals:
-    void sig_sendHeItems(std::vector<QListWidgetItem*>&);
-    void sig_sendVertexItems(std::vector<QListWidgetItem*>&);
-    void sig_sendFaceItems(std::vector<QListWidgetItem*>&);
+    void sig_sendElementCounts(int numVerts, int numHes, int numFaces, bool newMesh);
+
+    void sig_sendLevels(int numLevels, int level);
+    void sig_sendEditStats(int edits, int rebuilds);
 
     void sig_sendRootNode(QTreeWidgetItem*);
 
@@ -82,10 +143,11 @@ signals:
 
 public slots:
     void slot_loadOBJ();
+    void slot_saveMesh();
 
-    void slot_setSelectedVertex(QListWidgetItem*);
-    void slot_setSelectedHE(QListWidgetItem*);
-    void slot_setSelectedFace(QListWidgetItem*);
+    void slot_setSelectedVertex(const QModelIndex&);
+    void slot_setSelectedHE(const QModelIndex&);
+    void slot_setSelectedFace(const QModelIndex&);
 
     void slot_splitEdge();
     void slot_triangulateFace();
@@ -100,11 +162,25 @@ public slots:
 
     void slot_subdivide();
     void slot_extrude();
+    void slot_setEditCage(bool);
+    void slot_setLevel(int);
+    void slot_setSharedVertices(bool);
+
+    void slot_setShowFrameTimes(bool);
+    //stopping a recording asks where to save it
+    void slot_setRecordTrace(bool);
 
     void slot_loadJSON();
     void slot_skinMesh();
+    void slot_setBindToBones(bool);
+    void slot_setMaxInfluences(int);
+    void slot_setDualQuat(bool);
     void slot_setSelectedJoint(QTreeWidgetItem* item, int column);
 
+    void slot_loadClip();
+    void slot_setPlayClip(bool);
+    void slot_setCrowd(bool);
+
     void slot_posXRot();
     void slot_posYRot();
     void slot_posZRot();
@@ -115,6 +191,10 @@ public slots:
     void slot_newJointX(double);
     void slot_newJointY(double);
     void slot_newJointZ(double);
+
+private slots:
+    //poses the skeleton at the clip's current time and redraws
+    void slot_stepClip();
 };
 
 
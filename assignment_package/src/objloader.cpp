@@ -0,0 +1,463 @@
+#include "objloader.h"
+#include <mappedfile.h>
+#include <parallel.h>
+#include <trace.h>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline bool atLineEnd(const char* p, const char* end) {
+    return p == end || *p == '\n' || *p == '#';
+}
+
+inline void skipSpaces(const char*& p, const char* end) {
+    while (p < end && isSpace(*p)) {
+        p++;
+    }
+}
+
+inline void skipLine(const char*& p, const char* end) {
+    const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    p = newline ? newline + 1 : end;
+}
+
+bool parseFloat(const char*& p, const char* end, float& value) {
+    skipSpaces(p, end);
+    if (p < end && *p == '+') {
+        p++;
+    }
+#if defined(__cpp_lib_to_chars)
+    std::from_chars_result result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()) {
+        return false;
+    }
+    p = result.ptr;
+    return true;
+#else
+    //standard libraries without floating point from_chars. the mapped file
+    //isn't null terminated, so the token is copied out first
+    char token[64];
+    int n = 0;
+    while (p + n < end && n < 63 && !isSpace(p[n]) && p[n] != '\n') {
+        token[n] = p[n];
+        n++;
+    }
+    token[n] = '\0';
+    char* tokenEnd;
+    value = std::strtof(token, &tokenEnd);
+    if (tokenEnd == token) {
+        return false;
+    }
+    p += tokenEnd - token;
+    return true;
+#endif
+}
+
+bool parseInt(const char*& p, const char* end, long& value) {
+    std::from_chars_result result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()) {
+        return false;
+    }
+    p = result.ptr;
+    return true;
+}
+
+std::string lineError(const char* what, size_t line) {
+    return std::string(what) + " on line " + std::to_string(line);
+}
+
+//below this many bytes a file is parsed in one piece
+static const size_t MIN_CHUNK_BYTES = 1 << 20;
+
+static const uint32_t NO_INDEX = 0xFFFFFFFF;
+
+//a face corner whose index is negative. it counts back from however many
+//elements the chunk had read at that point, which is only global once the
+//counts of the chunks before it are known
+struct RelativeIndex {
+    uint32_t corner;
+    uint32_t line;
+    long local;
+};
+
+//everything parsed out of one newline-aligned slice of the file. indices are
+//chunk-local until the merge adds the prefix sums of the earlier chunks
+struct ObjChunk {
+    const char* begin;
+    const char* end;
+    size_t lines = 0;
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> fileNormals;
+    std::vector<uint32_t> faceOffsets = std::vector<uint32_t>(1, 0);
+    std::vector<uint32_t> faceIndices;
+    std::vector<RelativeIndex> relativeVerts;
+    //vn index per corner, NO_INDEX where the corner has none. only kept
+    //once the chunk sees its first v//n corner
+    bool hasNormals = false;
+    std::vector<uint32_t> cornerNormals;
+    std::vector<RelativeIndex> relativeNormals;
+
+    bool failed = false;
+    const char* what = nullptr;
+    size_t errorLine = 0;
+};
+
+bool fail(ObjChunk& chunk, const char* what) {
+    chunk.failed = true;
+    chunk.what = what;
+    chunk.errorLine = chunk.lines;
+    return false;
+}
+
+//obj indices start at 1, negative ones are left for the merge to resolve
+inline uint32_t chunkIndex(long index, uint32_t corner, size_t line, size_t count, std::vector<RelativeIndex>& relative) {
+    if (index > 0) {
+        return uint32_t(index - 1);
+    }
+    relative.push_back({corner, uint32_t(line), long(count) + index});
+    return 0;
+}
+
+bool parseChunk(ObjChunk& chunk) {
+    const char* p = chunk.begin;
+    const char* end = chunk.end;
+
+    while (p < end) {
+        chunk.lines++;
+        skipSpaces(p, end);
+        if (p + 1 >= end) {
+            break;
+        }
+
+        if (p[0] == 'v' && isSpace(p[1])) {
+            p++;
+            glm::vec3 v;
+            if (!parseFloat(p, end, v.x) || !parseFloat(p, end, v.y) || !parseFloat(p, end, v.z)) {
+                return fail(chunk, "bad vertex");
+            }
+            chunk.positions.push_back(v);
+        } else if (p[0] == 'v' && p[1] == 'n' && p + 2 < end && isSpace(p[2])) {
+            p += 2;
+            glm::vec3 n;
+            if (!parseFloat(p, end, n.x) || !parseFloat(p, end, n.y) || !parseFloat(p, end, n.z)) {
+                return fail(chunk, "bad normal");
+            }
+            chunk.fileNormals.push_back(n);
+        } else if (p[0] == 'f' && isSpace(p[1])) {
+            p++;
+            size_t faceStart = chunk.faceIndices.size();
+            while (true) {
+                skipSpaces(p, end);
+                if (atLineEnd(p, end)) {
+                    break;
+                }
+
+                long v, t, n;
+                uint32_t corner = chunk.faceIndices.size();
+                if (!parseInt(p, end, v) || v == 0) {
+                    return fail(chunk, "bad face index");
+                }
+                uint32_t ni = NO_INDEX;
+                if (p < end && *p == '/') {
+                    p++;
+                    //texture coordinates aren't used, but they still have to parse
+                    if (p < end && *p != '/' && !parseInt(p, end, t)) {
+                        return fail(chunk, "bad texture index");
+                    }
+                    if (p < end && *p == '/') {
+                        p++;
+                        if (!parseInt(p, end, n)) {
+                            return fail(chunk, "bad normal index");
+                        }
+                        if (n != 0) {
+                            ni = chunkIndex(n, corner, chunk.lines, chunk.fileNormals.size(), chunk.relativeNormals);
+                        }
+                    }
+                }
+                if (p < end && !isSpace(*p) && *p != '\n') {
+                    return fail(chunk, "bad face");
+                }
+
+                chunk.faceIndices.push_back(chunkIndex(v, corner, chunk.lines, chunk.positions.size(), chunk.relativeVerts));
+                if (ni != NO_INDEX && !chunk.hasNormals) {
+                    chunk.hasNormals = true;
+                    chunk.cornerNormals.assign(corner, NO_INDEX);
+                }
+                if (chunk.hasNormals) {
+                    chunk.cornerNormals.push_back(ni);
+                }
+            }
+
+            //points and lines written as faces can't go in a half-edge mesh
+            size_t numCorners = chunk.faceIndices.size() - faceStart;
+            if (numCorners < 3) {
+                chunk.faceIndices.resize(faceStart);
+                if (chunk.hasNormals) {
+                    chunk.cornerNormals.resize(faceStart);
+                }
+                while (!chunk.relativeVerts.empty() && chunk.relativeVerts.back().corner >= faceStart) {
+                    chunk.relativeVerts.pop_back();
+                }
+                while (!chunk.relativeNormals.empty() && chunk.relativeNormals.back().corner >= faceStart) {
+                    chunk.relativeNormals.pop_back();
+                }
+            } else {
+                chunk.faceOffsets.push_back(chunk.faceIndices.size());
+            }
+        }
+
+        skipLine(p, end);
+    }
+    return true;
+}
+
+//cuts [begin, end) into about one slice per thread, each starting at the
+//beginning of a line so no token straddles two chunks
+std::vector<ObjChunk> splitChunks(const char* begin, const char* end) {
+    size_t size = end - begin;
+    int pieces = size < MIN_CHUNK_BYTES ? 1 : int(std::min<size_t>(parallel::numThreads(), size / MIN_CHUNK_BYTES));
+
+    std::vector<ObjChunk> chunks;
+    const char* start = begin;
+    for (int i = 1; i <= pieces && start < end; i++) {
+        const char* stop = end;
+        if (i < pieces) {
+            stop = std::max(start, begin + size / pieces * i);
+            skipLine(stop, end);
+        }
+        ObjChunk chunk;
+        chunk.begin = start;
+        chunk.end = stop;
+        chunks.push_back(std::move(chunk));
+        start = stop;
+    }
+    return chunks;
+}
+
+//first failure in file order, with the chunk-local line made global
+bool firstError(const std::vector<ObjChunk>& chunks, const std::vector<size_t>& lineBase, std::string& error) {
+    for (size_t c = 0; c < chunks.size(); c++) {
+        if (chunks[c].failed) {
+            error = lineError(chunks[c].what, lineBase[c] + chunks[c].errorLine);
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
+int ObjData::numFaces() const {
+    return faceOffsets.empty() ? 0 : int(faceOffsets.size()) - 1;
+}
+
+bool loadOBJ(const std::string& path, ObjData& out, std::string& error) {
+    TRACE_ZONE("loadOBJ", "io");
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        error = "could not read " + path;
+        return false;
+    }
+    return parseOBJ(file.data(), file.data() + file.size(), out, error);
+}
+
+bool parseOBJ(const char* begin, const char* end, ObjData& out, std::string& error) {
+    out.positions.clear();
+    out.normals.clear();
+    out.faceOffsets.assign(1, 0);
+    out.faceIndices.clear();
+
+    std::vector<ObjChunk> chunks = splitChunks(begin, end);
+    int numChunks = chunks.size();
+    parallel::forTasks(numChunks, [&](int c) {
+        TRACE_ZONE("parseChunk", "io");
+        parseChunk(chunks[c]);
+    });
+
+    //where each chunk's lines, elements and corners start in the whole file
+    std::vector<size_t> lineBase(numChunks + 1, 0), posBase(numChunks + 1, 0), norBase(numChunks + 1, 0),
+                        faceBase(numChunks + 1, 0), cornerBase(numChunks + 1, 0);
+    bool anyNormals = false;
+    for (int c = 0; c < numChunks; c++) {
+        const ObjChunk& chunk = chunks[c];
+        lineBase[c + 1] = lineBase[c] + chunk.lines;
+        posBase[c + 1] = posBase[c] + chunk.positions.size();
+        norBase[c + 1] = norBase[c] + chunk.fileNormals.size();
+        faceBase[c + 1] = faceBase[c] + chunk.faceOffsets.size() - 1;
+        cornerBase[c + 1] = cornerBase[c] + chunk.faceIndices.size();
+        anyNormals = anyNormals || chunk.hasNormals;
+    }
+    if (firstError(chunks, lineBase, error)) {
+        return false;
+    }
+
+    size_t numPositions = posBase[numChunks];
+    std::vector<glm::vec3> fileNormals;
+    std::vector<uint32_t> cornerNormals;
+    //a single chunk is already laid out like the whole file, so its arrays
+    //are taken over as they are instead of copied
+    bool inPlace = numChunks == 1;
+    if (inPlace) {
+        out.positions.swap(chunks[0].positions);
+        out.faceOffsets.swap(chunks[0].faceOffsets);
+        out.faceIndices.swap(chunks[0].faceIndices);
+        fileNormals.swap(chunks[0].fileNormals);
+        cornerNormals.swap(chunks[0].cornerNormals);
+    } else {
+        out.positions.resize(numPositions);
+        out.faceOffsets.resize(faceBase[numChunks] + 1);
+        out.faceIndices.resize(cornerBase[numChunks]);
+        fileNormals.resize(norBase[numChunks]);
+        cornerNormals.assign(anyNormals ? cornerBase[numChunks] : 0, NO_INDEX);
+    }
+
+    //every chunk copies its slice into place and resolves its own indices
+    parallel::forTasks(numChunks, [&](int c) {
+        ObjChunk& chunk = chunks[c];
+        uint32_t *indices = out.faceIndices.data() + cornerBase[c];
+        uint32_t *normals = cornerNormals.data() + cornerBase[c];
+        if (!inPlace) {
+            std::copy(chunk.positions.begin(), chunk.positions.end(), out.positions.begin() + posBase[c]);
+            std::copy(chunk.fileNormals.begin(), chunk.fileNormals.end(), fileNormals.begin() + norBase[c]);
+            for (size_t f = 1; f < chunk.faceOffsets.size(); f++) {
+                out.faceOffsets[faceBase[c] + f] = cornerBase[c] + chunk.faceOffsets[f];
+            }
+            std::copy(chunk.faceIndices.begin(), chunk.faceIndices.end(), indices);
+            std::copy(chunk.cornerNormals.begin(), chunk.cornerNormals.end(), normals);
+        }
+
+        for (const RelativeIndex& r : chunk.relativeVerts) {
+            long global = long(posBase[c]) + r.local;
+            if (global < 0) {
+                fail(chunk, "bad face index");
+                chunk.errorLine = r.line;
+                break;
+            }
+            indices[r.corner] = uint32_t(global);
+        }
+
+        if (chunk.hasNormals) {
+            for (size_t k = 0; k < cornerBase[c + 1] - cornerBase[c]; k++) {
+                if (normals[k] >= norBase[numChunks]) {
+                    normals[k] = NO_INDEX;
+                }
+            }
+            //a normal index that reaches before the first vn is ignored,
+            //the position just doesn't get a normal from this corner
+            for (const RelativeIndex& r : chunk.relativeNormals) {
+                long global = long(norBase[c]) + r.local;
+                normals[r.corner] = global >= 0 ? uint32_t(global) : NO_INDEX;
+            }
+        }
+    });
+    if (firstError(chunks, lineBase, error)) {
+        return false;
+    }
+    chunks.clear();
+
+    //positive indices can point past what had been read at the time
+    std::vector<uint32_t> badIndex(numChunks, NO_INDEX);
+    parallel::forTasks(numChunks, [&](int c) {
+        for (size_t k = cornerBase[c]; k < cornerBase[c + 1]; k++) {
+            if (out.faceIndices[k] >= numPositions) {
+                badIndex[c] = out.faceIndices[k];
+                break;
+            }
+        }
+    });
+    for (uint32_t vi : badIndex) {
+        if (vi != NO_INDEX) {
+            error = "face index " + std::to_string(vi + 1) + " is past the last vertex";
+            return false;
+        }
+    }
+
+    //each position takes the normal of the first corner in the file that
+    //names one. the earliest corner is found with an atomic min so the
+    //result doesn't depend on which thread gets there first
+    out.normals.resize(numPositions);
+    if (anyNormals) {
+        std::vector<std::atomic<uint32_t>> firstCorner(numPositions);
+        parallel::forEach(int(numPositions), [&](int v) {
+            firstCorner[v].store(NO_INDEX, std::memory_order_relaxed);
+        });
+        parallel::forEach(int(cornerNormals.size()), [&](int k) {
+            if (cornerNormals[k] == NO_INDEX) {
+                return;
+            }
+            std::atomic<uint32_t>& first = firstCorner[out.faceIndices[k]];
+            uint32_t current = first.load(std::memory_order_relaxed);
+            while (uint32_t(k) < current && !first.compare_exchange_weak(current, k, std::memory_order_relaxed)) {}
+        });
+        parallel::forEach(int(numPositions), [&](int v) {
+            uint32_t k = firstCorner[v].load(std::memory_order_relaxed);
+            if (k != NO_INDEX) {
+                out.normals[v] = fileNormals[cornerNormals[k]];
+            }
+        });
+    }
+    return true;
+}
+
+bool writeOBJ(const std::string& path, const ObjData& obj, std::string& error) {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        error = "could not write " + path;
+        return false;
+    }
+
+    bool hasNormals = std::any_of(obj.normals.begin(), obj.normals.end(), [](const glm::vec3& n) {
+        return n != glm::vec3();
+    });
+
+    //lines are formatted into one buffer that is flushed whenever it fills,
+    //9 significant digits is enough to read back the same floats
+    std::string buffer;
+    buffer.reserve(1 << 20);
+    char line[128];
+    bool ok = true;
+    auto flush = [&](bool force) {
+        if (force || buffer.size() > (1 << 20) - 128) {
+            ok = ok && std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+            buffer.clear();
+        }
+    };
+
+    for (const glm::vec3& v : obj.positions) {
+        buffer.append(line, std::snprintf(line, sizeof(line), "v %.9g %.9g %.9g\n", v.x, v.y, v.z));
+        flush(false);
+    }
+    if (hasNormals) {
+        for (const glm::vec3& n : obj.normals) {
+            buffer.append(line, std::snprintf(line, sizeof(line), "vn %.9g %.9g %.9g\n", n.x, n.y, n.z));
+            flush(false);
+        }
+    }
+    for (int f = 0; f < obj.numFaces(); f++) {
+        buffer += 'f';
+        for (uint32_t k = obj.faceOffsets[f]; k < obj.faceOffsets[f + 1]; k++) {
+            uint32_t vi = obj.faceIndices[k] + 1;
+            buffer.append(line, hasNormals ? std::snprintf(line, sizeof(line), " %u//%u", vi, vi)
+                                           : std::snprintf(line, sizeof(line), " %u", vi));
+        }
+        buffer += '\n';
+        flush(false);
+    }
+    flush(true);
+
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        error = "could not write " + path;
+    }
+    return ok;
+}
@@ -0,0 +1,37 @@
+#ifndef OBJLOADER_H
+#define OBJLOADER_H
+
+#include <la.h>
+#include <string>
+#include <vector>
+
+//geometry read out of an obj file. faces are stored flat, face f's position
+//indices are faceIndices[faceOffsets[f]] up to faceIndices[faceOffsets[f + 1]]
+struct ObjData {
+    std::vector<glm::vec3> positions;
+    //one per position, taken from the first face corner in the file that
+    //pairs the position with a vn. zero if no corner does
+    std::vector<glm::vec3> normals;
+    std::vector<uint32_t> faceOffsets;
+    std::vector<uint32_t> faceIndices;
+
+    int numFaces() const;
+};
+
+//reads an obj file by memory mapping it and parsing in place, no per-line
+//strings or streams. understands v, vn and f, with faces written as v, v/t,
+//v//n or v/t/n and negative (relative) indices. everything else is skipped.
+//big files are cut into newline-aligned chunks that are parsed on their own
+//threads and stitched back together, the result is the same for any thread
+//count. on failure returns false and puts the reason in error
+bool loadOBJ(const std::string& path, ObjData& out, std::string& error);
+
+//same as loadOBJ on a buffer already in memory
+bool parseOBJ(const char* begin, const char* end, ObjData& out, std::string& error);
+
+//writes obj as v, vn and f lines. normals are written (one vn per position,
+//faces as v//n) only when obj.normals has some. on failure returns false and
+//puts the reason in error
+bool writeOBJ(const std::string& path, const ObjData& obj, std::string& error);
+
+#endif // OBJLOADER_H
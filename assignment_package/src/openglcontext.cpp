@@ -9,12 +9,21 @@
 
 
 OpenGLContext::OpenGLContext(QWidget *parent)
-    : QOpenGLWidget(parent)
+    : QOpenGLWidget(parent), bufferPool(this)
 {
 }
 
 OpenGLContext::~OpenGLContext()
 {
+    //subclasses' drawables are gone by now and have given their buffers
+    //back, so this frees every buffer the pool ever made
+    makeCurrent();
+    bufferPool.trim();
+}
+
+BufferPool& OpenGLContext::getBufferPool()
+{
+    return bufferPool;
 }
 
 inline const char *glGS(GLenum e)
@@ -2,6 +2,7 @@
 
 #include <QOpenGLWidget>
 #include <QOpenGLFunctions_3_2_Core>
+#include "glbuffer.h"
 
 class OpenGLContext
     : public QOpenGLWidget,
@@ -15,6 +16,9 @@ protected:
     /*** If true, save a test image and exit */
     /***/ bool autotesting;
 
+    //every Drawable's buffers come from here
+    BufferPool bufferPool;
+
 public:
     OpenGLContext(QWidget *parent);
     ~OpenGLContext();
@@ -24,6 +28,8 @@ public:
     void printLinkInfoLog(int prog);
     void printShaderInfoLog(int shader);
 
+    BufferPool& getBufferPool();
+
 private slots:
     /*** AUTOMATIC TESTING: DO NOT MODIFY ***/
     /***/ void saveImageAndQuit();
@@ -0,0 +1,84 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+//small data-parallel helpers for the mesh operators. a range is cut into
+//one contiguous chunk per hardware thread so every thread streams through
+//its own slice of the arrays; ranges too small to be worth a thread run inline
+namespace parallel {
+
+//below this many elements spawning threads costs more than it saves
+static const int MIN_PARALLEL_COUNT = 4096;
+
+inline int numThreads() {
+    int n = std::thread::hardware_concurrency();
+    return n > 0 ? n : 1;
+}
+
+//how many chunks forChunks will split count elements into
+inline int chunksFor(int count) {
+    if (count < MIN_PARALLEL_COUNT) {
+        return 1;
+    }
+    return std::min(numThreads(), count / (MIN_PARALLEL_COUNT / 4));
+}
+
+//runs fn(chunk, begin, end) over [0, count) split into chunksFor(count) pieces.
+//chunk indices and ranges are deterministic, so callers can keep per-chunk
+//partial results and combine them afterwards (e.g. for prefix sums)
+template <typename F>
+void forChunks(int count, F fn) {
+    int chunks = chunksFor(count);
+    if (chunks <= 1) {
+        fn(0, 0, count);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(chunks - 1);
+    int per = (count + chunks - 1) / chunks;
+    for (int c = 1; c < chunks; c++) {
+        int begin = std::min(count, c * per), end = std::min(count, begin + per);
+        threads.emplace_back([=, &fn]() { fn(c, begin, end); });
+    }
+    //the calling thread takes the first chunk instead of idling
+    fn(0, 0, std::min(count, per));
+    for (std::thread& t : threads) {
+        t.join();
+    }
+}
+
+//runs fn(task) for every task in [0, tasks), one thread each. for work that
+//is already split into a few big uneven pieces (e.g. byte ranges of a file)
+//where forChunks' element count threshold doesn't apply
+template <typename F>
+void forTasks(int tasks, F fn) {
+    std::vector<std::thread> threads;
+    threads.reserve(std::max(0, tasks - 1));
+    for (int t = 1; t < tasks; t++) {
+        threads.emplace_back([t, &fn]() { fn(t); });
+    }
+    if (tasks > 0) {
+        fn(0);
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+}
+
+//runs fn(i) for every i in [0, count)
+template <typename F>
+void forEach(int count, F fn) {
+    forChunks(count, [&fn](int, int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            fn(i);
+        }
+    });
+}
+
+}
+
+#endif // PARALLEL_H
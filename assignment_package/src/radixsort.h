@@ -0,0 +1,67 @@
+#ifndef RADIXSORT_H
+#define RADIXSORT_H
+
+#include <parallel.h>
+#include <cstdint>
+#include <vector>
+
+namespace parallel {
+
+//stable lsd radix sort of keys, carrying values along. only the low keyBits
+//bits are looked at, so small key ranges take fewer passes. every pass
+//histograms each chunk on its own thread, prefix sums the histograms in
+//(digit, chunk) order and then scatters each chunk into place, which keeps
+//equal keys in their original order
+template <typename V>
+void radixSortByKey(std::vector<uint64_t>& keys, std::vector<V>& values, int keyBits) {
+    static const int DIGIT_BITS = 11;
+    static const int BUCKETS = 1 << DIGIT_BITS;
+
+    int count = keys.size();
+    int chunks = chunksFor(count);
+    std::vector<uint64_t> keysOut(count);
+    std::vector<V> valuesOut(count);
+    std::vector<uint32_t> offsets(chunks * BUCKETS);
+
+    for (int shift = 0; shift < keyBits; shift += DIGIT_BITS) {
+        std::fill(offsets.begin(), offsets.end(), 0);
+        forChunks(count, [&](int chunk, int begin, int end) {
+            uint32_t *histogram = &offsets[chunk * BUCKETS];
+            for (int i = begin; i < end; i++) {
+                histogram[(keys[i] >> shift) & (BUCKETS - 1)]++;
+            }
+        });
+
+        //a digit every key shares doesn't reorder anything
+        bool sorted = false;
+        uint32_t start = 0;
+        for (int digit = 0; digit < BUCKETS; digit++) {
+            uint32_t total = 0;
+            for (int chunk = 0; chunk < chunks; chunk++) {
+                uint32_t n = offsets[chunk * BUCKETS + digit];
+                offsets[chunk * BUCKETS + digit] = start + total;
+                total += n;
+            }
+            sorted = sorted || total == uint32_t(count);
+            start += total;
+        }
+        if (sorted) {
+            continue;
+        }
+
+        forChunks(count, [&](int chunk, int begin, int end) {
+            uint32_t *next = &offsets[chunk * BUCKETS];
+            for (int i = begin; i < end; i++) {
+                uint32_t slot = next[(keys[i] >> shift) & (BUCKETS - 1)]++;
+                keysOut[slot] = keys[i];
+                valuesOut[slot] = values[i];
+            }
+        });
+        keys.swap(keysOut);
+        values.swap(valuesOut);
+    }
+}
+
+}
+
+#endif // RADIXSORT_H
@@ -1,6 +1,7 @@
 #include "shaderprogram.h"
 #include <QFile>
 #include <QStringBuilder>
+#include <trace.h>
 #include <iostream>
 #include <exception>
 
@@ -8,12 +9,13 @@
 ShaderProgram::ShaderProgram(OpenGLContext *context)
     : vertShader(), fragShader(), prog(),
       attrPos(-1), attrNor(-1), attrCol(-1), attrIds(-1), attrWeights(-1),
-      unifModel(-1), unifModelInvTr(-1), unifViewProj(-1), unifCamPos(-1), unifBinds(-1), unifTransforms(-1),
+      unifModel(-1), unifModelInvTr(-1), unifViewProj(-1), unifCamPos(-1), unifJointMatrices(-1), unifJointOffset(-1), unifJointsPerInstance(-1), unifSelectedJoint(-1),
       context(context)
 {}
 
 void ShaderProgram::create(const char *vertfile, const char *fragfile)
 {
+    TRACE_ZONE("ShaderProgram::create", "shader");
     // Allocate space on our GPU for a vertex shader and a fragment shader and a shader program to manage the two
     vertShader = context->glCreateShader(GL_VERTEX_SHADER);
     fragShader = context->glCreateShader(GL_FRAGMENT_SHADER);
@@ -72,8 +74,10 @@ void ShaderProgram::create(const char *vertfile, const char *fragfile)
     unifViewProj   = context->glGetUniformLocation(prog, "u_ViewProj");
     unifCamPos     = context->glGetUniformLocation(prog, "u_CamPos");
 
-    unifBinds      = context->glGetUniformLocation(prog, "u_Binds");
-    unifTransforms = context->glGetUniformLocation(prog, "u_Transforms");
+    unifJointMatrices = context->glGetUniformLocation(prog, "u_JointMatrices");
+    unifJointOffset   = context->glGetUniformLocation(prog, "u_JointOffset");
+    unifJointsPerInstance = context->glGetUniformLocation(prog, "u_JointsPerInstance");
+    unifSelectedJoint = context->glGetUniformLocation(prog, "u_SelectedJoint");
 }
 
 void ShaderProgram::useMe()
@@ -139,27 +143,35 @@ void ShaderProgram::setCamPos(glm::vec3 pos)
     }
 }
 
-//new hw7 function
-void ShaderProgram::setBinds(std::array<glm::mat4, 100>& arr, int mCount) {
+void ShaderProgram::setJointPalette(JointPalette& palette, int offset, int jointsPerInstance) {
     useMe();
 
-    if (unifBinds != -1) {
-        context->glUniformMatrix4fv(unifBinds, mCount, GL_FALSE, &arr[0][0][0]);
+    //the palette is the only texture, so it lives on unit 0
+    palette.bind(0);
+    if (unifJointMatrices != -1) {
+        context->glUniform1i(unifJointMatrices, 0);
+    }
+    if (unifJointOffset != -1) {
+        context->glUniform1i(unifJointOffset, offset);
+    }
+    if (unifJointsPerInstance != -1) {
+        context->glUniform1i(unifJointsPerInstance, jointsPerInstance);
     }
 }
 
-//new hw7 function
-void ShaderProgram::setTransforms(std::array<glm::mat4, 100>& arr, int mCount) {
+void ShaderProgram::setSelectedJoint(int joint) {
     useMe();
 
-    if (unifTransforms != -1) {
-        context->glUniformMatrix4fv(unifTransforms, mCount, GL_FALSE, &arr[0][0][0]);
+    if (unifSelectedJoint != -1) {
+        context->glUniform1i(unifSelectedJoint, joint);
     }
 }
 
 //This function, as its name implies, uses the passed in GL widget
-void ShaderProgram::draw(Drawable &d)
+void ShaderProgram::draw(Drawable &d, int instances)
 {
+    trace::Zone traceZone("ShaderProgram::draw", "shader");
+    traceZone.arg("elements", d.elemCount());
     if(d.elemCount() < 0) {
         throw std::invalid_argument(
         "Attempting to draw a Drawable that has not initialized its count variable! Remember to set it to the length of your index array in create()."
@@ -178,34 +190,38 @@ void ShaderProgram::draw(Drawable &d)
         // (referred to by attrPos) with that VBO
     if (attrPos != -1 && d.bindPos()) {
         context->glEnableVertexAttribArray(attrPos);
-        context->glVertexAttribPointer(attrPos, 4, GL_FLOAT, false, 0, nullptr);
+        context->glVertexAttribPointer(attrPos, d.attrSize(), GL_FLOAT, false, 0, nullptr);
     }
 
     if (attrNor != -1 && d.bindNor()) {
         context->glEnableVertexAttribArray(attrNor);
-        context->glVertexAttribPointer(attrNor, 4, GL_FLOAT, false, 0, nullptr);
+        context->glVertexAttribPointer(attrNor, d.attrSize(), GL_FLOAT, false, 0, nullptr);
     }
 
     if (attrCol != -1 && d.bindCol()) {
         context->glEnableVertexAttribArray(attrCol);
-        context->glVertexAttribPointer(attrCol, 4, GL_FLOAT, false, 0, nullptr);
+        context->glVertexAttribPointer(attrCol, d.attrSize(), GL_FLOAT, false, 0, nullptr);
     }
 
     //new attrs for hw7
     if (attrIds != -1 && d.bindIds()) {
         context->glEnableVertexAttribArray(attrIds);
-        context->glVertexAttribIPointer(attrIds, 2, GL_INT, 0, nullptr);
+        context->glVertexAttribIPointer(attrIds, 4, GL_UNSIGNED_SHORT, 0, nullptr);
     }
 
     if (attrWeights != -1 && d.bindWeights()) {
         context->glEnableVertexAttribArray(attrWeights);
-        context->glVertexAttribPointer(attrWeights, 2, GL_FLOAT, false, 0, nullptr);
+        context->glVertexAttribPointer(attrWeights, 4, GL_UNSIGNED_SHORT, true, 0, nullptr);
     }
 
     // Bind the index buffer and then draw shapes from it.
     // This invokes the shader program, which accesses the vertex buffers.
     d.bindIdx();
-    context->glDrawElements(d.drawMode(), d.elemCount(), GL_UNSIGNED_INT, 0);
+    if (instances > 1) {
+        context->glDrawElementsInstanced(d.drawMode(), d.elemCount(), GL_UNSIGNED_INT, 0, instances);
+    } else {
+        context->glDrawElements(d.drawMode(), d.elemCount(), GL_UNSIGNED_INT, 0);
+    }
 
     if (attrPos != -1) context->glDisableVertexAttribArray(attrPos);
     if (attrNor != -1) context->glDisableVertexAttribArray(attrNor);
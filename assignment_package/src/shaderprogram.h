@@ -6,6 +6,7 @@
 #include <glm/glm.hpp>
 
 #include "drawable.h"
+#include "jointpalette.h"
 
 
 class ShaderProgram
@@ -27,8 +28,10 @@ public:
     int unifViewProj; // A handle for the "uniform" mat4 representing combined projection and view matrices in the vertex shader
     int unifCamPos; // A handle for the "uniform" vec4 representing color of geometry in the vertex shader
 
-    int unifBinds; //new handle for hw7 that is a handle for the bind matrices
-    int unifTransforms; //new handle for hw7 that is a handle for the transformation matrices
+    int unifJointMatrices; //the joint palette's texture buffer
+    int unifJointOffset; //where the drawn skeleton's joints start in the palette
+    int unifJointsPerInstance; //palette stride between instances of an instanced draw
+    int unifSelectedJoint; //joint the joint shader highlights
 
 public:
     ShaderProgram(OpenGLContext* context);
@@ -43,12 +46,15 @@ public:
     // Pass the given color to this shader on the GPU
     void setCamPos(glm::vec3 pos);
 
-    //new setters for binds and transforms for hw7
-    void setBinds(std::array<glm::mat4, 100>& arr, int mCount);
-    void setTransforms(std::array<glm::mat4, 100>& arr, int mCount);
+    //skins with the palette's joints starting at offset, see JointPalette::add.
+    //instance i of an instanced draw starts jointsPerInstance * i further on
+    void setJointPalette(JointPalette& palette, int offset, int jointsPerInstance = 0);
+    //which joint the joint gizmos highlight, -1 for none
+    void setSelectedJoint(int joint);
 
-    // Draw the given object to our screen using this ShaderProgram's shaders
-    void draw(Drawable &d);
+    // Draw the given object to our screen using this ShaderProgram's shaders.
+    // More than one instance draws them all in one instanced call
+    void draw(Drawable &d, int instances = 1);
     // Utility function used in create()
     char* textFileRead(const char*);
     // Utility function that prints any shader compilation errors to the console
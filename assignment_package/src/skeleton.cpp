@@ -0,0 +1,152 @@
+#include "skeleton.h"
+#include <algorithm>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+int Skeleton::numJoints() const {
+    return parents.size();
+}
+
+glm::mat4 Skeleton::localTransform(int j) const {
+    return glm::translate(glm::mat4(), positions[j]) * glm::toMat4(rotations[j]);
+}
+
+std::vector<glm::mat4> Skeleton::worldTransforms() const {
+    std::vector<glm::mat4> world(numJoints());
+    for (int j = 0; j < numJoints(); j++) {
+        world[j] = parents[j] < 0 ? localTransform(j) : world[parents[j]] * localTransform(j);
+    }
+    return world;
+}
+
+std::vector<glm::vec3> Skeleton::worldPositions() const {
+    std::vector<glm::mat4> world = worldTransforms();
+    std::vector<glm::vec3> positions(world.size());
+    for (size_t j = 0; j < world.size(); j++) {
+        positions[j] = glm::vec3(world[j] * glm::vec4(0, 0, 0, 1));
+    }
+    return positions;
+}
+
+SkeletonPose::SkeletonPose(const Skeleton& skeleton)
+    : parents(skeleton.parents), positions(skeleton.positions), rotations(skeleton.rotations),
+      locals(skeleton.numJoints()), worlds(skeleton.numJoints()), binds(skeleton.numJoints(), glm::mat4()),
+      dirty(skeleton.numJoints(), LOCAL_DIRTY | WORLD_DIRTY), anyDirty(true)
+{
+    update();
+}
+
+int SkeletonPose::numJoints() const {
+    return parents.size();
+}
+
+int SkeletonPose::getParent(int j) const {
+    return parents[j];
+}
+
+glm::vec3 SkeletonPose::getPosition(int j) const {
+    return positions[j];
+}
+
+glm::quat SkeletonPose::getRotation(int j) const {
+    return rotations[j];
+}
+
+void SkeletonPose::setPosition(int j, glm::vec3 pos) {
+    positions[j] = pos;
+    dirty[j] = LOCAL_DIRTY | WORLD_DIRTY;
+    anyDirty = true;
+}
+
+void SkeletonPose::setRotation(int j, glm::quat rot) {
+    rotations[j] = rot;
+    dirty[j] = LOCAL_DIRTY | WORLD_DIRTY;
+    anyDirty = true;
+}
+
+int SkeletonPose::update() {
+    if (!anyDirty) {
+        return 0;
+    }
+    int updated = 0;
+    for (int j = 0; j < numJoints(); j++) {
+        int p = parents[j];
+        //a recomputed parent leaves WORLD_DIRTY set for the rest of the
+        //pass, which is how the change reaches the whole subtree
+        if (p >= 0 && (dirty[p] & WORLD_DIRTY)) {
+            dirty[j] |= WORLD_DIRTY;
+        }
+        if (!dirty[j]) {
+            continue;
+        }
+        if (dirty[j] & LOCAL_DIRTY) {
+            locals[j] = glm::translate(glm::mat4(), positions[j]) * glm::toMat4(rotations[j]);
+        }
+        worlds[j] = p < 0 ? locals[j] : worlds[p] * locals[j];
+        updated++;
+    }
+    std::fill(dirty.begin(), dirty.end(), 0);
+    anyDirty = false;
+    return updated;
+}
+
+const glm::mat4& SkeletonPose::getLocal(int j) const {
+    return locals[j];
+}
+
+const glm::mat4& SkeletonPose::getWorld(int j) const {
+    return worlds[j];
+}
+
+glm::vec3 SkeletonPose::getWorldPosition(int j) const {
+    return glm::vec3(worlds[j][3]);
+}
+
+const std::vector<glm::mat4>& SkeletonPose::getWorldTransforms() const {
+    return worlds;
+}
+
+void SkeletonPose::bind() {
+    update();
+    for (int j = 0; j < numJoints(); j++) {
+        binds[j] = glm::inverse(worlds[j]);
+    }
+}
+
+const std::vector<glm::mat4>& SkeletonPose::getBindTransforms() const {
+    return binds;
+}
+
+static void readJointRec(const QJsonObject& joint, int parent, Skeleton& out) {
+    QJsonArray currPos = joint["pos"].toArray(), currRot = joint["rot"].toArray(), currChildren = joint["children"].toArray();
+
+    glm::vec3 axis = glm::vec3(currRot[1].toDouble(), currRot[2].toDouble(), currRot[3].toDouble());
+    int j = out.numJoints();
+    out.names.push_back(joint["name"].toString().toStdString());
+    out.parents.push_back(parent);
+    out.positions.push_back(glm::vec3(currPos[0].toDouble(), currPos[1].toDouble(), currPos[2].toDouble()));
+    out.rotations.push_back(glm::quat(glm::angleAxis(float(currRot[0].toDouble()), axis)));
+
+    for (int i = 0; i < currChildren.size(); i++) {
+        readJointRec(currChildren[i].toObject(), j, out);
+    }
+}
+
+bool loadSkeletonJSON(const std::string& path, Skeleton& out, std::string& error) {
+    out = Skeleton();
+    QFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        error = "could not read " + path;
+        return false;
+    }
+    QJsonDocument json = QJsonDocument::fromJson(file.readAll());
+    QJsonObject root = json.object()["root"].toObject();
+    if (root.isEmpty()) {
+        error = path + " has no root joint";
+        return false;
+    }
+    readJointRec(root, -1, out);
+    return true;
+}
@@ -0,0 +1,74 @@
+#ifndef SKELETON_H
+#define SKELETON_H
+
+#include <la.h>
+#include <string>
+#include <vector>
+
+//a joint hierarchy as flat arrays, with no gl or widgets attached. joints
+//are stored parents first (the order the json lists them in), so a joint's
+//parent always comes before it and the root is joint 0
+struct Skeleton {
+    std::vector<std::string> names;
+    std::vector<int> parents; //-1 for the root
+    std::vector<glm::vec3> positions; //relative to the parent
+    std::vector<glm::quat> rotations;
+
+    int numJoints() const;
+    glm::mat4 localTransform(int j) const;
+    //parent transforms applied in order, one per joint
+    std::vector<glm::mat4> worldTransforms() const;
+    std::vector<glm::vec3> worldPositions() const;
+};
+
+//a skeleton being posed. every joint's local and world transform is cached
+//in flat arrays in the skeleton's parents-first order. edits just flag the
+//joint, and update() recomputes the flagged joints and everything below
+//them in one pass from the root down, since a parent's world transform is
+//always done by the time its children are reached
+class SkeletonPose {
+public:
+    explicit SkeletonPose(const Skeleton& skeleton);
+
+    int numJoints() const;
+    int getParent(int j) const;
+    glm::vec3 getPosition(int j) const;
+    glm::quat getRotation(int j) const;
+    void setPosition(int j, glm::vec3 pos);
+    void setRotation(int j, glm::quat rot);
+
+    //brings the world transforms up to date, returns how many joints were
+    //recomputed. costs nothing when no joint has been edited
+    int update();
+    //these are as of the last update()
+    const glm::mat4& getLocal(int j) const;
+    const glm::mat4& getWorld(int j) const;
+    glm::vec3 getWorldPosition(int j) const;
+    const std::vector<glm::mat4>& getWorldTransforms() const;
+
+    //makes the current pose the bind pose, each joint's bind transform is
+    //the inverse of its world transform. identity until the first bind()
+    void bind();
+    const std::vector<glm::mat4>& getBindTransforms() const;
+
+private:
+    //LOCAL means the joint's own position or rotation changed, WORLD that
+    //its world transform has to be recomputed
+    enum { LOCAL_DIRTY = 1, WORLD_DIRTY = 2 };
+
+    std::vector<int> parents;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::quat> rotations;
+    std::vector<glm::mat4> locals;
+    std::vector<glm::mat4> worlds;
+    std::vector<glm::mat4> binds;
+    std::vector<uint8_t> dirty;
+    bool anyDirty;
+};
+
+//reads a skeleton json, the same format the joint tree in the app loads:
+//{"root": {"name", "pos": [x, y, z], "rot": [angle, x, y, z], "children": [...]}}.
+//on failure returns false and puts the reason in error
+bool loadSkeletonJSON(const std::string& path, Skeleton& out, std::string& error);
+
+#endif // SKELETON_H
@@ -1,36 +1,28 @@
 INCLUDEPATH += $$PWD
 DEPENDPATH += $$PWD
 
+include(core.pri)
+include(gl.pri)
+
 SOURCES += \
-    $$PWD/component.cpp \
     $$PWD/drawablecomponent.cpp \
-    $$PWD/joint.cpp \
+    $$PWD/elementlistmodel.cpp \
+    $$PWD/jointpalette.cpp \
     $$PWD/main.cpp \
     $$PWD/mainwindow.cpp \
-    $$PWD/mesh.cpp \
     $$PWD/mygl.cpp \
     $$PWD/shaderprogram.cpp \
-    $$PWD/utils.cpp \
-    $$PWD/la.cpp \
-    $$PWD/drawable.cpp \
     $$PWD/camera.cpp \
     $$PWD/cameracontrolshelp.cpp \
-    $$PWD/openglcontext.cpp \
     $$PWD/scene/squareplane.cpp
 
 HEADERS += \
-    $$PWD/component.h \
     $$PWD/drawablecomponent.h \
-    $$PWD/joint.h \
-    $$PWD/la.h \
+    $$PWD/elementlistmodel.h \
+    $$PWD/jointpalette.h \
     $$PWD/mainwindow.h \
-    $$PWD/mesh.h \
     $$PWD/mygl.h \
     $$PWD/shaderprogram.h \
-    $$PWD/utils.h \
-    $$PWD/drawable.h \
     $$PWD/camera.h \
     $$PWD/cameracontrolshelp.h \
-    $$PWD/openglcontext.h \
-    $$PWD/scene/squareplane.h\
-    $$PWD/smartpointerhelp.h
+    $$PWD/scene/squareplane.h
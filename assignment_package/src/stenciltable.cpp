@@ -0,0 +1,91 @@
+#include "stenciltable.h"
+
+StencilTable::StencilTable() : offsets(1, 0), indices(), weights(), columnOffsets(1, 0), columnRows()
+{}
+
+StencilTable StencilTable::identity(int n) {
+    StencilTable table;
+    table.offsets.resize(n + 1);
+    table.indices.resize(n);
+    table.weights.assign(n, 1.f);
+    for (int i = 0; i < n; i++) {
+        table.offsets[i] = i;
+        table.indices[i] = i;
+    }
+    table.offsets[n] = n;
+    table.buildColumns(n);
+    return table;
+}
+
+int StencilTable::numStencils() const {
+    return offsets.size() - 1;
+}
+
+int StencilTable::numEntries() const {
+    return indices.size();
+}
+
+bool StencilTable::isEmpty() const {
+    return numStencils() == 0;
+}
+
+StencilTable StencilTable::compose(const StencilTable& first) const {
+    //each of this table's terms refers to a row of first, so substituting
+    //that row in gives a row in terms of first's control vertices
+    return build(numStencils(), first.columnOffsets.size() - 1, [&](int i, std::vector<Entry>& row) {
+        for (uint32_t k = offsets[i]; k < offsets[i + 1]; k++) {
+            uint32_t mid = indices[k];
+            float w = weights[k];
+            for (uint32_t j = first.offsets[mid]; j < first.offsets[mid + 1]; j++) {
+                row.push_back(Entry(first.indices[j], w * first.weights[j]));
+            }
+        }
+    });
+}
+
+void StencilTable::evaluate(const std::vector<glm::vec3>& control, std::vector<glm::vec3>& out) const {
+    out.resize(numStencils());
+    parallel::forEach(numStencils(), [&](int i) {
+        glm::vec3 p(0.f);
+        for (uint32_t k = offsets[i]; k < offsets[i + 1]; k++) {
+            p += weights[k] * control[indices[k]];
+        }
+        out[i] = p;
+    });
+}
+
+void StencilTable::evaluateColumn(const std::vector<glm::vec3>& control, std::vector<glm::vec3>& out, uint32_t c, std::vector<uint32_t>& rows) const {
+    //the rows are recomputed from scratch rather than nudged by the delta so
+    //repeated edits don't pile up rounding error
+    for (uint32_t r = columnOffsets[c]; r < columnOffsets[c + 1]; r++) {
+        uint32_t i = columnRows[r];
+        glm::vec3 p(0.f);
+        for (uint32_t k = offsets[i]; k < offsets[i + 1]; k++) {
+            p += weights[k] * control[indices[k]];
+        }
+        out[i] = p;
+        rows.push_back(i);
+    }
+}
+
+void StencilTable::clear() {
+    *this = StencilTable();
+}
+
+void StencilTable::buildColumns(int numControls) {
+    //counting sort of the terms by control vertex
+    columnOffsets.assign(numControls + 1, 0);
+    for (uint32_t c : indices) {
+        columnOffsets[c + 1]++;
+    }
+    for (int c = 0; c < numControls; c++) {
+        columnOffsets[c + 1] += columnOffsets[c];
+    }
+    columnRows.resize(indices.size());
+    std::vector<uint32_t> fill(columnOffsets.begin(), columnOffsets.end() - 1);
+    for (int i = 0; i < numStencils(); i++) {
+        for (uint32_t k = offsets[i]; k < offsets[i + 1]; k++) {
+            columnRows[fill[indices[k]]++] = i;
+        }
+    }
+}
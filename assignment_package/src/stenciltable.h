@@ -0,0 +1,114 @@
+#ifndef STENCILTABLE_H
+#define STENCILTABLE_H
+
+#include <la.h>
+#include <parallel.h>
+#include <algorithm>
+#include <vector>
+
+//a sparse linear map from control vertices to refined vertices, stored as
+//compressed rows: refined vertex i is
+//    sum over k in [offsets[i], offsets[i+1]) of weights[k] * control[indices[k]]
+//once built, moving control vertices only needs these weighted sums re-run,
+//the refined topology never has to be rebuilt
+class StencilTable {
+private:
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> indices;
+    std::vector<float> weights;
+
+    //transpose of the rows, which refined vertices each control vertex feeds.
+    //lets an edit re-evaluate only the rows it can change
+    std::vector<uint32_t> columnOffsets;
+    std::vector<uint32_t> columnRows;
+
+public:
+    //one (control index, weight) term of a stencil row
+    typedef std::pair<uint32_t, float> Entry;
+
+    StencilTable();
+
+    //every refined vertex is its own control vertex
+    static StencilTable identity(int n);
+
+    //builds numRows rows in parallel. rowFn(i, row) appends the raw terms for
+    //row i, repeated control indices are merged and zero weights dropped
+    template <typename F>
+    static StencilTable build(int numRows, int numControls, F rowFn);
+
+    int numStencils() const;
+    int numEntries() const;
+    bool isEmpty() const;
+
+    //the table that applies first and then this one
+    StencilTable compose(const StencilTable& first) const;
+
+    //out[i] = stencil i applied to control, for every row
+    void evaluate(const std::vector<glm::vec3>& control, std::vector<glm::vec3>& out) const;
+    //re-evaluates only the rows that depend on control vertex c, and appends
+    //their indices to rows
+    void evaluateColumn(const std::vector<glm::vec3>& control, std::vector<glm::vec3>& out, uint32_t c, std::vector<uint32_t>& rows) const;
+
+    void clear();
+
+private:
+    void buildColumns(int numControls);
+};
+
+template <typename F>
+StencilTable StencilTable::build(int numRows, int numControls, F rowFn) {
+    //each chunk writes its rows into its own compressed buffers, then the
+    //chunks are stitched together at offsets from a prefix sum of their sizes
+    int numChunks = parallel::chunksFor(numRows);
+    std::vector<std::vector<uint32_t>> chunkIndices(numChunks);
+    std::vector<std::vector<float>> chunkWeights(numChunks);
+
+    StencilTable table;
+    table.offsets.resize(numRows + 1);
+    table.offsets[0] = 0;
+
+    parallel::forChunks(numRows, [&](int chunk, int begin, int end) {
+        std::vector<Entry> row;
+        std::vector<uint32_t> &idx = chunkIndices[chunk];
+        std::vector<float> &wts = chunkWeights[chunk];
+        for (int i = begin; i < end; i++) {
+            row.clear();
+            rowFn(i, row);
+            std::sort(row.begin(), row.end(), [](const Entry& a, const Entry& b) {
+                return a.first < b.first;
+            });
+            //merge repeated control vertices into one term
+            uint32_t rowSize = 0;
+            for (int k = 0; k < (int)row.size();) {
+                uint32_t c = row[k].first;
+                float w = 0.f;
+                for (; k < (int)row.size() && row[k].first == c; k++) {
+                    w += row[k].second;
+                }
+                if (w != 0.f) {
+                    idx.push_back(c);
+                    wts.push_back(w);
+                    rowSize++;
+                }
+            }
+            //row sizes for now, turned into offsets below
+            table.offsets[i + 1] = rowSize;
+        }
+    });
+
+    for (int i = 0; i < numRows; i++) {
+        table.offsets[i + 1] += table.offsets[i];
+    }
+    table.indices.resize(table.offsets[numRows]);
+    table.weights.resize(table.offsets[numRows]);
+
+    parallel::forChunks(numRows, [&](int chunk, int begin, int) {
+        std::copy(chunkIndices[chunk].begin(), chunkIndices[chunk].end(), table.indices.begin() + table.offsets[begin]);
+        std::copy(chunkWeights[chunk].begin(), chunkWeights[chunk].end(), table.weights.begin() + table.offsets[begin]);
+    });
+
+    table.buildColumns(numControls);
+    return table;
+}
+
+#endif // STENCILTABLE_H
@@ -0,0 +1,126 @@
+#include "threadpool.h"
+#include <trace.h>
+#include <algorithm>
+
+ThreadPool::ThreadPool(int numThreads)
+    : queues(std::max(1, numThreads)), workers(),
+      lock(), wake(), done(), job(nullptr), generation(0), busyWorkers(0), stopping(false)
+{
+    for (int w = 1; w < int(queues.size()); w++) {
+        workers.emplace_back([this, w]() { workerLoop(w); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : workers) {
+        t.join();
+    }
+}
+
+int ThreadPool::numThreads() const {
+    return queues.size();
+}
+
+void ThreadPool::run(int tasks, const std::function<void(int)>& fn) {
+    if (tasks <= 0) {
+        return;
+    }
+    if (workers.empty() || tasks == 1) {
+        for (int t = 0; t < tasks; t++) {
+            fn(t);
+        }
+        return;
+    }
+
+    int n = numThreads();
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (int q = 0; q < n; q++) {
+            std::lock_guard<std::mutex> queueGuard(queues[q].lock);
+            queues[q].begin = int(int64_t(tasks) * q / n);
+            queues[q].end = int(int64_t(tasks) * (q + 1) / n);
+        }
+        job = &fn;
+        busyWorkers = int(workers.size());
+        generation++;
+    }
+    wake.notify_all();
+    work(0);
+
+    //fn has to outlive every worker still inside the job
+    std::unique_lock<std::mutex> guard(lock);
+    done.wait(guard, [this]() { return busyWorkers == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::workerLoop(int self) {
+    trace::nameThread("pool worker");
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [this, seen]() { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+        work(self);
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (--busyWorkers == 0) {
+                done.notify_all();
+            }
+        }
+    }
+}
+
+void ThreadPool::work(int self) {
+    int task;
+    while (pop(self, task) || steal(self, task)) {
+        (*job)(task);
+    }
+}
+
+bool ThreadPool::pop(int self, int& task) {
+    Queue& q = queues[self];
+    std::lock_guard<std::mutex> guard(q.lock);
+    if (q.begin >= q.end) {
+        return false;
+    }
+    task = q.begin++;
+    return true;
+}
+
+bool ThreadPool::steal(int self, int& task) {
+    //tasks only ever move between queues once a job starts, so once every
+    //queue has been seen empty the job is out of work
+    int n = numThreads();
+    for (int i = 1; i < n; i++) {
+        Queue& victim = queues[(self + i) % n];
+        int begin, end;
+        {
+            std::lock_guard<std::mutex> guard(victim.lock);
+            int left = victim.end - victim.begin;
+            if (left <= 0) {
+                continue;
+            }
+            end = victim.end;
+            begin = end - (left + 1) / 2;
+            victim.end = begin;
+        }
+        //run the first stolen task now and queue the rest as our own
+        task = begin;
+        Queue& own = queues[self];
+        std::lock_guard<std::mutex> guard(own.lock);
+        own.begin = begin + 1;
+        own.end = end;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,56 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//worker threads that stay alive between jobs, for work that runs every
+//frame where parallel:: spawning fresh threads each call would cost more
+//than the work. a job's tasks start split evenly across one queue per
+//thread, and a thread that empties its own queue steals half of what's
+//left in someone else's, so uneven tasks still keep every thread busy
+class ThreadPool {
+public:
+    //numThreads counts the calling thread, which works on every job too
+    explicit ThreadPool(int numThreads);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int numThreads() const;
+    //runs fn(task) for every task in [0, tasks), returns once they're all
+    //done. one job at a time, from one thread
+    void run(int tasks, const std::function<void(int)>& fn);
+
+private:
+    //the tasks [begin, end) a thread still has to run. the owner takes from
+    //the front, thieves take from the back
+    struct alignas(64) Queue {
+        std::mutex lock;
+        int begin = 0;
+        int end = 0;
+    };
+
+    void workerLoop(int self);
+    //runs tasks until there are none left anywhere
+    void work(int self);
+    bool pop(int self, int& task);
+    bool steal(int self, int& task);
+
+    std::vector<Queue> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(int)>* job;
+    uint64_t generation; //bumped for every job so sleeping workers see it
+    int busyWorkers;     //workers that haven't finished the current job
+    bool stopping;
+};
+
+#endif // THREADPOOL_H
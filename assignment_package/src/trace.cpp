@@ -0,0 +1,163 @@
+#include <trace.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace trace {
+
+namespace {
+
+//a recording stops collecting past this many events, about 100MB
+const int MAX_EVENTS = 1 << 21;
+
+struct Event {
+    const char* name;
+    const char* category; //null for counters
+    const char* argName;
+    double value;
+    int64_t begin, end;
+    uint32_t tid;
+};
+
+std::atomic<bool> g_recording(false);
+std::atomic<uint32_t> g_nextTid(0);
+
+//zones are coarse (a few hundred a frame at most), so one lock around one
+//array is cheaper to live with than per-thread buffers that have to be
+//found and merged, and parallel:: spawns fresh threads for every call anyway
+std::mutex g_lock;
+std::vector<Event> g_events;
+std::map<uint32_t, std::string> g_threadNames;
+int g_dropped = 0;
+int64_t g_startTime = 0;
+
+uint32_t threadId() {
+    thread_local uint32_t tid = g_nextTid.fetch_add(1);
+    return tid;
+}
+
+void push(const Event& e) {
+    std::lock_guard<std::mutex> lock(g_lock);
+    if (!g_recording.load(std::memory_order_relaxed)) {
+        return;
+    }
+    if (int(g_events.size()) >= MAX_EVENTS) {
+        g_dropped++;
+        return;
+    }
+    g_events.push_back(e);
+}
+
+void writeEscaped(FILE* file, const char* s) {
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') {
+            std::fputc('\\', file);
+        }
+        std::fputc(*s, file);
+    }
+}
+
+}
+
+int64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void start() {
+    std::lock_guard<std::mutex> lock(g_lock);
+    g_events.clear();
+    g_dropped = 0;
+    g_startTime = now();
+    g_recording.store(true);
+}
+
+void stop() {
+    g_recording.store(false);
+}
+
+bool recording() {
+    return g_recording.load(std::memory_order_relaxed);
+}
+
+int numEvents() {
+    std::lock_guard<std::mutex> lock(g_lock);
+    return int(g_events.size());
+}
+
+int numDropped() {
+    std::lock_guard<std::mutex> lock(g_lock);
+    return g_dropped;
+}
+
+void nameThread(const char* name) {
+    uint32_t tid = threadId();
+    std::lock_guard<std::mutex> lock(g_lock);
+    g_threadNames[tid] = name;
+}
+
+void zone(const char* name, const char* category, int64_t begin, int64_t end,
+          const char* argName, double argValue) {
+    push({name, category, argName, argValue, begin, end, threadId()});
+}
+
+void counter(const char* name, double value) {
+    if (!recording()) {
+        return;
+    }
+    int64_t t = now();
+    push({name, nullptr, nullptr, value, t, t, threadId()});
+}
+
+bool writeChromeJSON(const std::string& path, std::string& error) {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        error = "could not write " + path;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(g_lock);
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+    bool first = true;
+    for (const auto& thread : g_threadNames) {
+        std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"",
+                     first ? "" : ",\n", thread.first);
+        writeEscaped(file, thread.second.c_str());
+        std::fputs("\"}}", file);
+        first = false;
+    }
+    //timestamps are microseconds from the start of the recording
+    for (const Event& e : g_events) {
+        std::fputs(first ? "{\"name\":\"" : ",\n{\"name\":\"", file);
+        writeEscaped(file, e.name);
+        if (e.category) {
+            std::fputs("\",\"cat\":\"", file);
+            writeEscaped(file, e.category);
+            std::fprintf(file, "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u",
+                         (e.begin - g_startTime) * 1e-3, (e.end - e.begin) * 1e-3, e.tid);
+            if (e.argName) {
+                std::fputs(",\"args\":{\"", file);
+                writeEscaped(file, e.argName);
+                std::fprintf(file, "\":%.17g}", e.value);
+            }
+            std::fputc('}', file);
+        } else {
+            std::fprintf(file, "\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"value\":%.17g}}",
+                         (e.begin - g_startTime) * 1e-3, e.tid, e.value);
+        }
+        first = false;
+    }
+    std::fputs("\n]}\n", file);
+
+    if (std::fclose(file) != 0) {
+        error = "could not write " + path;
+        return false;
+    }
+    return true;
+}
+
+}
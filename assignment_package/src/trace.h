@@ -0,0 +1,69 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <string>
+
+//lightweight always-on instrumentation. code marks scoped zones and
+//counters, and while a recording is running they're collected with the
+//thread they ran on and can be written out as chrome://tracing / perfetto
+//json. with no recording running a zone costs one relaxed atomic load
+namespace trace {
+
+//nanoseconds on a steady clock, only meaningful relative to each other
+int64_t now();
+
+void start();
+//events recorded so far are kept until the next start()
+void stop();
+bool recording();
+int numEvents();
+//events that didn't fit in the buffer and were thrown away
+int numDropped();
+
+//shows up as the thread's name in the trace viewer
+void nameThread(const char* name);
+
+//names and categories must outlive the recording, i.e. string literals
+void zone(const char* name, const char* category, int64_t begin, int64_t end,
+          const char* argName = nullptr, double argValue = 0.0);
+void counter(const char* name, double value);
+
+//writes everything recorded as a chrome trace event json file
+bool writeChromeJSON(const std::string& path, std::string& error);
+
+//times the scope it's declared in
+class Zone {
+public:
+    explicit Zone(const char* name, const char* category = "app")
+        : name(name), category(category), argName(nullptr), argValue(0.0), begin(recording() ? now() : -1) {}
+    ~Zone() {
+        if (begin >= 0) {
+            zone(name, category, begin, now(), argName, argValue);
+        }
+    }
+    Zone(const Zone&) = delete;
+    Zone& operator=(const Zone&) = delete;
+
+    //one number shown with the zone, e.g. how many faces it touched
+    void arg(const char* n, double value) {
+        argName = n;
+        argValue = value;
+    }
+
+private:
+    const char* name;
+    const char* category;
+    const char* argName;
+    double argValue;
+    int64_t begin;
+};
+
+}
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+//TRACE_ZONE("name") or TRACE_ZONE("name", "category")
+#define TRACE_ZONE(...) trace::Zone TRACE_CONCAT(traceZone, __LINE__)(__VA_ARGS__)
+
+#endif // TRACE_H